@@ -10,21 +10,6 @@
 namespace AlgorithmHelpers
 {
 
-//-------------------------------------------------------------------------
-void visitNeighborhood(Coord loc, float radius, std::function<void(Coord)> f, const Parameters& params)
-{
-    for (int dx = -std::min<int>(radius, loc.x); dx <= std::min<int>(radius, (params.sizeX - loc.x) - 1); ++dx) {
-        int16_t x = loc.x + dx;
-        assert(x >= 0 && x < params.sizeX);
-        int extentY = (int)sqrt(radius * radius - dx * dx);
-        for (int dy = -std::min<int>(extentY, loc.y); dy <= std::min<int>(extentY, (params.sizeY - loc.y) - 1); ++dy) {
-            int16_t y = loc.y + dy;
-            assert(y >= 0 && y < params.sizeY);
-            f( Coord { x, y} );
-        }
-    }
-}
-
 //-------------------------------------------------------------------------
 float getPopulationDensityAlongAxis(Coord loc, Dir dir, const Grid& grid, const Parameters& params)
 {
@@ -139,7 +124,7 @@ float responseCurve(float r, const Parameters& params)
 bool prob2bool(float factor, RandomUintGenerator& random)
 {
     assert(factor >= 0.0 && factor <= 1.0);
-    return (random() / (float)RANDOM_UINT_MAX) < factor;
+    return random.uniform() < factor;
 }
 
 } // namespace AlgorithmHelpers
\ No newline at end of file
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "BasicTypes.h"
+#include "Parameters.h"
 
-#include <functional>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
-class Parameters;
 class Grid;
 class Peep;
 class RandomUintGenerator;
@@ -15,7 +17,22 @@ namespace AlgorithmHelpers
 //! This is a utility function used when inspecting a local neighborhood around
 //! some location. This function feeds each valid (in-bounds) location in the specified
 //! neighborhood to the specified function. Locations include self (center of the neighborhood).
-void visitNeighborhood(Coord loc, float radius, std::function<void(Coord)> f, const Parameters& params);
+//! The function is a template so that the sensors' lambdas are called inline and
+//! their captures are never copied to the heap.
+template <typename Function>
+void visitNeighborhood(Coord loc, float radius, Function&& f, const Parameters& params)
+{
+    for (int dx = -std::min<int>(radius, loc.x); dx <= std::min<int>(radius, (params.sizeX - loc.x) - 1); ++dx) {
+        int16_t x = loc.x + dx;
+        assert(x >= 0 && x < params.sizeX);
+        int extentY = (int)sqrt(radius * radius - dx * dx);
+        for (int dy = -std::min<int>(extentY, loc.y); dy <= std::min<int>(extentY, (params.sizeY - loc.y) - 1); ++dy) {
+            int16_t y = loc.y + dy;
+            assert(y >= 0 && y < params.sizeY);
+            f( Coord { x, y} );
+        }
+    }
+}
 
 //! Converts the population along the specified axis to the sensor range. The
 //! locations of neighbors are scaled by the inverse of their distance times
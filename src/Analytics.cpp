@@ -12,6 +12,8 @@ void Analytics::Clear()
     m_SurvivorsToNextGen.clear();
     m_CompletedChallengeTasks.clear();
     m_ChallengeTaskCount = 0;
+    m_StepTimes.clear();
+    m_TurnoverTimes.clear();
 }
 
 //-------------------------------------------------------------------------
@@ -22,6 +24,7 @@ void Analytics::ClearProcessedCounts()
     m_ProcessedChallengeTasks = 0;
     m_ProcessedAvgAge = 0;
     m_ProcessedSurvNextGen = 0;
+    m_ProcessedGenTimes = 0;
 }
 
 //-------------------------------------------------------------------------
@@ -89,6 +92,9 @@ std::vector<std::string> Analytics::GetAnalyticsNames()
       case Analytics::eType::CompletedTasks:
         names.push_back("Completed Tasks");
         break;
+      case Analytics::eType::GenerationTimes:
+        names.push_back("Generation times (ms)");
+        break;
       case Analytics::eType::NoOfAnalytics:
       default:
         break;
@@ -148,4 +154,16 @@ std::pair<unsigned, std::vector<std::vector<unsigned> > > Analytics::GetComplete
     auto oldProcessedCount = m_ProcessedChallengeTasks;
     m_ProcessedChallengeTasks = currentSize;
     return {oldProcessedCount, range};
+}
+
+//-------------------------------------------------------------------------
+std::pair<unsigned, std::vector<std::vector<float> > > Analytics::GetGenerationTimes()
+{
+    assert(m_ProcessedGenTimes <= m_StepTimes.size());
+    std::vector<std::vector<float> > range{
+        std::vector<float>(m_StepTimes.begin() + m_ProcessedGenTimes, m_StepTimes.end()),
+        std::vector<float>(m_TurnoverTimes.begin() + m_ProcessedGenTimes, m_TurnoverTimes.end())};
+    auto oldProcessedCount = m_ProcessedGenTimes;
+    m_ProcessedGenTimes = m_StepTimes.size();
+    return {oldProcessedCount, range};
 }
\ No newline at end of file
@@ -18,6 +18,7 @@ public:
         CompletedTasks,   ///< Stores the completeing peeps counts for each challenge task.
         AvgAge,           ///< Stores the average age of the generation.
         SurvivorToNextGen,///< Stores the count of survivors that will respawn in the next gen.
+        GenerationTimes,  ///< Stores the average sim step time and the generation turnover time.
         NoOfAnalytics
     };
     
@@ -51,6 +52,13 @@ public:
     std::pair<unsigned, std::vector<std::vector<unsigned> > > GetCompletedChallengeTaskCounts();
     //! Adds a count of successfull peeps for each task.
     void AddCompletedChallengeTaskCounts(const std::vector<unsigned>& values);
+    //! Returns the average sim step times and the turnover times in milliseconds, in this order.
+    //! It only sends the vector of times, that has not been sent out yet.
+    //! \a m_ProcessedGenTimes keeps count of processed values.
+    //! Returns the pair of the processed index and the vector of data.
+    std::pair<unsigned, std::vector<std::vector<float> > > GetGenerationTimes();
+    //! Adds the average sim step time and the time spent spawning the next generation, in milliseconds.
+    void AddGenerationTimes(float stepTime, float turnoverTime) { m_StepTimes.push_back(stepTime); m_TurnoverTimes.push_back(turnoverTime); }
     //! Returns the analytics type names.
     static std::vector<std::string> GetAnalyticsNames();
     //! Resets all statistics. Should only happen on "Reset" system request or on Challenge change.
@@ -58,6 +66,8 @@ public:
     //! Clears only the processed counts. Useful when analyticstype is changed.
     void ClearProcessedCounts();
 private:
+    friend class Checkpoint;    ///< Saves and restores the history.
+
     std::vector<unsigned> m_Survivors{};      ///< Contains the survivor count of each generation.
     unsigned m_ProcessedSurvivors{};          ///< Contains the index of the last polled survivor count.
     std::vector<float> m_GeneticDiversity{};  ///< Contains the genetic diversity count of each generation.
@@ -71,5 +81,8 @@ private:
     unsigned m_ProcessedAvgAge{};             ///< Contains the count of challenge tasks.
     std::vector<unsigned> m_SurvivorsToNextGen{}; ///< Contains the survivors count that will be respawn in the next generation
     unsigned m_ProcessedSurvNextGen{};        ///< Contains the count of challenge tasks.
+    std::vector<float> m_StepTimes{};         ///< Contains the average sim step time of each generation.
+    std::vector<float> m_TurnoverTimes{};     ///< Contains the time spent spawning the next generation.
+    unsigned m_ProcessedGenTimes{};           ///< Contains the index of the last polled generation times.
 };
 
@@ -2,6 +2,7 @@
 
 #include "QMLInterface.h"
 #include "qml/ChartsConnector.h"
+#include "qml/PeepsItem.h"
 
 #include <QQmlEngine>
 #include <QQmlContext>
@@ -15,6 +16,7 @@ App::App(int argc, char *argv[])
 {
     qmlRegisterType<QML::QMLInterface>("backendGuiInterface", 1, 0, "QMLInterface");
     qmlRegisterType<QML::ChartsConnector>("backendGuiInterface", 1, 0, "ChartsConnector");
+    qmlRegisterType<QML::PeepsItem>("backendGuiInterface", 1, 0, "PeepsItem");
     m_MainView.engine()->rootContext()->setContextProperty("_window", &m_MainView);
     m_MainView.setResizeMode(QQuickView::SizeRootObjectToView);
     m_MainView.setSource(QUrl("qrc:/qml/main.qml"));
@@ -3,12 +3,19 @@
 #include "Analytics.h"
 #include "AlgorithmHelpers.h"
 #include "BasicTypes.h"
+#include "Checkpoint.h"
 #include "Challenges/Altruism.h"
 #include "Challenges/iChallenges.h"
+#include "FrameRecorder.h"
+#include "SensorFields.h"
+#include "SensorPyramids.h"
 #include "SensorsActions.h"
+#include "SpatialOrder.h"
+#include "Trajectory.h"
 
 #include <QColor>
-#include <QPoint>
+
+#include <chrono>
 
 
 //---------------------------------------------------------------------------
@@ -18,6 +25,9 @@ Backend::Backend()
   , m_xGrid(std::make_unique<Grid>(m_xParameterIO->GetParamRef(), *m_xRandomGenerator.get()))
   , m_xSignals(std::make_unique<PheromoneSignals>(m_xParameterIO->GetParamRef()))
   , m_xSensors(std::make_unique<Sensors>())
+  , m_xSensorFields(std::make_unique<SensorFields>(m_xParameterIO->GetParamRef()))
+  , m_xSensorPyramids(std::make_unique<SensorPyramids>(m_xParameterIO->GetParamRef()))
+  , m_xSpatialOrder(std::make_unique<SpatialOrder>(m_xParameterIO->GetParamRef()))
   , m_xPeeps(std::make_unique<PeepsPool>(*m_xGrid.get()))
   , m_xActions(std::make_unique<Actions>(
       *m_xPeeps.get(),
@@ -28,6 +38,8 @@ Backend::Backend()
   ))
   , m_xChallenge(std::make_unique<Challenges::Altruism>(*m_xRandomGenerator.get(), m_xParameterIO->GetParamRef()))
   , m_xAnalytics(std::make_unique<Analytics>())
+  , m_xFrameRecorder(std::make_unique<FrameRecorder>(m_xParameterIO->GetParamRef()))
+  , m_xTrajectoryRecorder(std::make_unique<TrajectoryRecorder>(m_xParameterIO->GetParamRef()))
   , m_xGenerationGenerator(std::make_unique<GenerationGenerator>(
       *m_xGrid.get(), 
       *m_xPeeps.get(), 
@@ -36,6 +48,18 @@ Backend::Backend()
       m_xParameterIO->GetParamRef(),
       *m_xRandomGenerator.get(),
       m_BarrierType,
+      m_CurrentChallenge,
+      m_Barriers))
+  , m_xCheckpoint(std::make_unique<Checkpoint>(
+      *m_xGrid.get(),
+      *m_xPeeps.get(),
+      *m_xSignals.get(),
+      *m_xAnalytics.get(),
+      *m_xSensors.get(),
+      *m_xActions.get(),
+      *m_xGenerationGenerator.get(),
+      *m_xRandomGenerator.get(),
+      m_xParameterIO->GetParamRef(),
       m_Barriers))
   , m_xSysStateMachine(std::make_unique<SysStateMachine>())
   , m_BarrierType(static_cast<eBarrierType>(m_xParameterIO->GetParamRef().barrierType))
@@ -143,13 +167,20 @@ void Backend::Run()
     // will be reused in each new generation.
     m_xGrid->init(); // the land on which the peeps live
     m_xSignals->init(parameters.signalLayers, parameters.sizeX, parameters.sizeY);  // where the pheromones waft
-    m_xPeeps->init(parameters.population, parameters); // the peeps themselves
+    m_xPeeps->init(parameters.population); // the peeps themselves
+    m_xSensorFields->Init(); // the precomputed neighborhood sensors
+    m_xSensors->UseSensorFields(m_xSensorFields.get());
+    m_xSensorPyramids->Init(); // the long-radius sensors
+    m_xSensors->UseSensorPyramids(m_xSensorPyramids.get());
     SetChallengeId(static_cast<unsigned>(m_CurrentChallenge));
     m_BarrierType = static_cast<eBarrierType>(parameters.barrierType);
+    m_xGenerationGenerator->LoadGenomeBanks(); // the genomes to seed generation 0
 
     // Define functions called in the system state machine
     auto reset = [this]() { Backend::Reset();} ;
     auto checkParameters = [this]() { return Backend::CheckParameters(); };
+    const std::string checkpointPath = parameters.logDir + "/checkpoint.bin";
+    bool restorePending = parameters.restoreCheckpoint;
 
     while (!m_ThreadStop)
     {
@@ -161,27 +192,44 @@ void Backend::Run()
             static_cast<eBarrierType>(parameters.barrierType),
             m_xSensors->AvailableSensorTypeCount(),
             m_xActions->AvailableActionTypeCount()); // starting population
+            // Only the first start continues from the checkpoint.
+            if (restorePending) {
+                restorePending = false;
+                m_xCheckpoint->Restore(checkpointPath, m_Generation, static_cast<unsigned>(m_CurrentChallenge));
+            }
         }
 
         while (!m_ThreadStop && m_xSysStateMachine->GenerationRunning()) { // generation loop
             unsigned murderCount = 0; // for reporting purposes
+            unsigned stepCount = 0;
+            auto stepsStart = std::chrono::steady_clock::now();
+            m_xSensorFields->SelectFields(*m_xPeeps.get(), *m_xSensors.get());
+            m_xSensorPyramids->SelectPyramids(*m_xPeeps.get(), *m_xSensors.get());
+            m_xSensors->PrepareGeneticSimilarity(*m_xPeeps.get(), m_xParameterIO->GetParamRef());
+            m_xTrajectoryRecorder->BeginGeneration(m_Generation, *m_xPeeps.get());
             for (unsigned simStep = 0; simStep < parameters.stepsPerGeneration && m_xSysStateMachine->SimStepRunning(); ++simStep) {
                 m_xSysStateMachine->Evaluate(checkParameters, reset);
-                // multithreaded loop: index 0 is reserved, start at 1
+                m_xSensorFields->Update(*m_xGrid.get(), *m_xSignals.get());
+                m_xSensorPyramids->Update(*m_xGrid.get(), *m_xSignals.get());
+                m_xSpatialOrder->Update(*m_xPeeps.get(), simStep);
+                // multithreaded loop over the living peeps only, the dead slots are skipped.
+                // The static schedule gives each thread a contiguous part of the list.
+                const auto& livePeeps = m_xPeeps->livePeeps();
                 auto& randomUint = *m_xRandomGenerator.get();
-    #pragma omp parallel for num_threads(parameters.numThreads) default(shared) firstprivate(randomUint) lastprivate(randomUint) schedule(auto)
-                for (unsigned peepIndex = 1; peepIndex <= parameters.population; ++peepIndex) {
-                    if ((*m_xPeeps.get())[peepIndex].alive) {
-                        SimStepOnePeep((*m_xPeeps.get())[peepIndex], simStep, randomUint);
-                    }
+    #pragma omp parallel for num_threads(parameters.numThreads) default(shared) firstprivate(randomUint) lastprivate(randomUint) schedule(static)
+                for (size_t liveIndex = 0; liveIndex < livePeeps.size(); ++liveIndex) {
+                    SimStepOnePeep((*m_xPeeps.get())[livePeeps[liveIndex]], simStep, randomUint);
                 }
                 // In single-thread mode: this executes deferred, queued deaths and movements,
                 // updates signal layers (pheromone), etc.
                 murderCount += m_xPeeps->deathQueueSize();
                 endOfSimStep(simStep, m_Generation);
+                ++stepCount;
             }
+            std::chrono::duration<float, std::milli> stepsTime = std::chrono::steady_clock::now() - stepsStart;
 
             endOfGeneration(m_Generation);
+            auto turnoverStart = std::chrono::steady_clock::now();
             unsigned numberSurvivors = 
                 m_xGenerationGenerator->spawnNewGeneration(
                     m_Generation,
@@ -189,6 +237,8 @@ void Backend::Run()
                     m_xChallenge.get(),
                     m_xSensors->AvailableSensorTypeCount(),
                     m_xActions->AvailableActionTypeCount());
+            std::chrono::duration<float, std::milli> turnoverTime = std::chrono::steady_clock::now() - turnoverStart;
+            m_xAnalytics->AddGenerationTimes(stepCount > 0 ? stepsTime.count() / stepCount : 0.0f, turnoverTime.count());
             // if (numberSurvivors > 0 && (m_Generation % parameters.genomeAnalysisStride == 0)) {
             //     Genetics::displaySampleGenomes(parameters.displaySampleGenomes, *m_xPeeps.get(), parameters);
             // }
@@ -197,6 +247,10 @@ void Backend::Run()
             } else {
                 ++m_Generation;
             }
+            if (parameters.checkpointStride > 0 && m_Generation > 0 && m_Generation % parameters.checkpointStride == 0) {
+                m_xCheckpoint->Save(checkpointPath, m_Generation, static_cast<unsigned>(m_CurrentChallenge));
+            }
+            m_xCheckpoint->PollSnapshots();
         }
         //Genetics::displaySampleGenomes(3, *m_xPeeps.get(), parameters); // final report, for debugging
     }
@@ -212,6 +266,8 @@ void Backend::SimStepOnePeep(Peep &peep, unsigned simStep, RandomUintGenerator&
         *m_xPeeps.get(),
         *m_xSignals.get(),
         *m_xSensors.get(),
+        *m_xGrid.get(),
+        m_xParameterIO->GetParamRef(),
         random);
     m_xActions->executeActions(peep, simStep, actionLevels);
 }
@@ -226,7 +282,8 @@ void Backend::endOfSimStep(unsigned simStep, unsigned generation)
 
     m_xPeeps->drainDeathQueue();
     m_xPeeps->drainMoveQueue();
-    m_xSignals->fade(0); // takes layerNum  todo!!!
+    m_xGrid->releaseEmptyChunks();
+    m_xSignals->update();
 
     saveVideoFrameSync(simStep, generation);
 }
@@ -235,6 +292,8 @@ void Backend::endOfSimStep(unsigned simStep, unsigned generation)
 void Backend::endOfGeneration(unsigned generation)
 {
     auto params = m_xParameterIO->GetParamRef();
+    m_xFrameRecorder->EndGeneration(generation);
+    m_xTrajectoryRecorder->EndGeneration();
     {
         if (params.updateGraphLog && (generation == 1 || ((generation % params.updateGraphLogStride) == 0))) {
 #pragma GCC diagnostic ignored "-Wunused-result"
@@ -244,34 +303,50 @@ void Backend::endOfGeneration(unsigned generation)
 }
 
 //---------------------------------------------------------------------------
-//! Converts uint8 to QColor for the UI.
+WorldData Backend::GetWorldData()
+{
+    // Only the scalars are copied, the bulk data is handed out by GetPeepSprites() and
+    // GetSignalLayerImage(). The barrier list is implicitly shared.
+    WorldData data{};
+    m_Lock.lockForRead();
+    data.maxPopulation = m_WorldData.maxPopulation;
+    data.simStep = m_WorldData.simStep;
+    data.generation = m_WorldData.generation;
+    data.barrierLocs = m_WorldData.barrierLocs;
+    data.signalLayerCount = m_WorldData.signalLayerCount;
+    data.signalLayerSize = m_WorldData.signalLayerSize;
+    m_Lock.unlock();
+    return data;
+}
+
 //---------------------------------------------------------------------------
-QColor ConvertUint8ToQColor(uint8_t c)
+void Backend::GetPeepSprites(std::vector<PeepSprite>& sprites)
 {
-    constexpr uint8_t maxColorVal = 0xb0;
-    constexpr uint8_t maxLumaVal = 0xb0;
-    auto rgbToLuma = [](uint8_t r, uint8_t g, uint8_t b) { return (r + r + r + b + g + g + g + g) / 8; };
-    
-    uint8_t r = (c);                  // R: 0..255
-    uint8_t g = ((c & 0x1f) << 3);    // G: 0..255
-    uint8_t b = ((c & 7)    << 5);    // B: 0..255
-
-    // Prevent color mappings to very bright colors (hard to see):
-    if (rgbToLuma(r, g, b) > maxLumaVal) {
-        if (r > maxColorVal) r %= maxColorVal;
-        if (g > maxColorVal) g %= maxColorVal;
-        if (b > maxColorVal) b %= maxColorVal;
-    }
-    return QColor(r, g, b);
+    m_Lock.lockForRead();
+    sprites.assign(m_WorldData.peepSprites.begin(), m_WorldData.peepSprites.end());
+    m_Lock.unlock();
 }
 
 //---------------------------------------------------------------------------
-WorldData Backend::GetWorldData()
+QImage Backend::GetSignalLayerImage(unsigned layer)
 {
-    m_Lock.lockForWrite();
-    auto data = m_WorldData;
+    m_SignalFrameRequested = true;
+
+    m_Lock.lockForRead();
+    WorldData::SignalLayer buffer = layer < m_WorldData.signalLayers.size() ? m_WorldData.signalLayers[layer] : nullptr;
+    QSize size = m_WorldData.signalLayerSize;
     m_Lock.unlock();
-    return data;
+
+    if (!buffer) {
+        QImage empty(1, 1, QImage::Format_Grayscale8);
+        empty.fill(0);
+        return empty;
+    }
+    // The image holds a reference to the buffer until it is released, the sim thread
+    // publishes into a new buffer meanwhile.
+    auto pOwner = new WorldData::SignalLayer(std::move(buffer));
+    return QImage((*pOwner)->data(), size.height(), size.width(), size.height(), QImage::Format_Grayscale8,
+                  [](void* pInfo) { delete static_cast<WorldData::SignalLayer*>(pInfo); }, pOwner);
 }
 
 //---------------------------------------------------------------------------
@@ -282,19 +357,40 @@ void Backend::saveVideoFrameSync(unsigned simStep, unsigned generation)
     // saveFrameThread() is using it to output a video frame.
     m_WorldData.simStep = simStep;
     m_WorldData.generation = generation;
-    m_WorldData.signalLayers.clear();
+    m_WorldData.signalLayerCount = m_xSignals->layerCount();
     m_WorldData.maxPopulation = m_xParameterIO->GetParamRef().population;
 
+    if (m_xFrameRecorder->IsRecording(generation)) {
+        m_xFrameRecorder->AddFrame(simStep, generation, *m_xGrid.get(), *m_xPeeps.get(), *m_xSignals.get());
+    }
+    m_xTrajectoryRecorder->AddStep(*m_xPeeps.get());
+
+    // The pheromone layers are only copied out when the UI asked for them, one
+    // contiguous block per layer.
+    if (m_SignalFrameRequested.exchange(false)) {
+        const auto& params = m_xParameterIO->GetParamRef();
+        const size_t layerSize = size_t(params.sizeX) * params.sizeY;
+        m_Lock.lockForWrite();
+        m_WorldData.signalLayers.resize(m_xSignals->layerCount());
+        m_WorldData.signalLayerSize = QSize(params.sizeX, params.sizeY);
+        for (uint16_t layerNum = 0; layerNum < m_xSignals->layerCount(); ++layerNum) {
+            auto& layer = m_WorldData.signalLayers[layerNum];
+            if (!layer || layer.use_count() > 1 || layer->size() != layerSize) {
+                layer = std::make_shared<std::vector<uint8_t>>(layerSize);
+            }
+            m_xSignals->copyLayer(layerNum, layer->data());
+        }
+        m_Lock.unlock();
+    }
+
     {
         m_Lock.lockForWrite();
-        m_WorldData.peepsPositions.clear();
-        m_WorldData.peepsColors.clear();
-        for (uint16_t index = 1; index <= m_xParameterIO->GetParamRef().population; ++index) {
+        m_WorldData.peepSprites.clear();
+        for (PeepIndex index : m_xPeeps->livePeeps()) {
             const Peep &peep = (*m_xPeeps.get())[index];
-            if (peep.alive) {
-                m_WorldData.peepsPositions.append(QPoint(peep.loc.x, peep.loc.y));
-                m_WorldData.peepsColors.append(ConvertUint8ToQColor(Genetics::makeGeneticColor(peep.genome)));
-            }
+            QColor color = ConvertUint8ToQColor(Genetics::makeGeneticColor(peep.genome));
+            m_WorldData.peepSprites.push_back({peep.loc.x, peep.loc.y,
+                uint8_t(color.red()), uint8_t(color.green()), uint8_t(color.blue())});
         }
         m_Lock.unlock();
     }
@@ -386,6 +482,12 @@ std::pair<uint16_t, uint16_t> Backend::GetFrameSize() const
     return { m_xParameterIO->GetParamRef().sizeX, m_xParameterIO->GetParamRef().sizeY }; 
 };
 
+//---------------------------------------------------------------------------
+std::string Backend::GetTrajectoryPath(unsigned generation) const
+{
+    return TrajectoryRecorder::FilePath(m_xParameterIO->GetParamRef(), generation);
+}
+
 //---------------------------------------------------------------------------
 void Backend::ClearAnalyticsProcessedCount()
 {
@@ -404,4 +506,10 @@ std::pair<unsigned, std::vector<std::vector<unsigned> > > Backend::GetCompletedC
 std::pair<unsigned, std::vector<float> > Backend::GetAvgAges() const
 {
     return m_xAnalytics->GetAvgAges();
+}
+
+//---------------------------------------------------------------------------
+std::pair<unsigned, std::vector<std::vector<float> > > Backend::GetGenerationTimes() const
+{
+    return m_xAnalytics->GetGenerationTimes();
 }
\ No newline at end of file
@@ -8,16 +8,33 @@
 #include "PheromoneSignals.h"
 #include "SysStateMachine.h"
 
+#include <QImage>
 #include <QMetaType>
 #include <QObject>
 #include <QReadWriteLock>
 #include <QSize>
 #include <QVariantList>
 
+#include <atomic>
 #include <memory>
 
 class Sensors;
+class SensorFields;
+class SensorPyramids;
+class SpatialOrder;
 class Actions;
+class FrameRecorder;
+class TrajectoryRecorder;
+class Checkpoint;
+
+//! A peep as drawn by the UI, its location and its genetic color.
+struct PeepSprite {
+    int16_t x;
+    int16_t y;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
 
 // This holds all data needed to construct one image frame. The data is
 // cached in this structure so that the image writer can work on it in
@@ -28,17 +45,19 @@ public:
     unsigned maxPopulation;
     unsigned simStep;
     unsigned generation;
-    QVariantList peepsPositions{};
-    QVariantList peepsColors{};
+    std::vector<PeepSprite> peepSprites{};  // Living peeps, see Backend::GetPeepSprites()
     QVariantList barrierLocs;
-    typedef std::vector<std::vector<uint8_t>> SignalLayer;  // [x][y]
-    std::vector<SignalLayer> signalLayers; // [layer][x][y]
+    unsigned signalLayerCount;
+    // The pheromone layers are only published on request, see Backend::GetSignalLayerImage().
+    // A buffer still referenced by an image on the UI side is never overwritten.
+    typedef std::shared_ptr<std::vector<uint8_t>> SignalLayer;  // [x][y], see PheromoneSignals::copyLayer()
+    std::vector<SignalLayer> signalLayers; // [layer]
+    QSize signalLayerSize;
     Q_PROPERTY(unsigned maxPopulation MEMBER maxPopulation)
     Q_PROPERTY(unsigned simStep MEMBER simStep)
     Q_PROPERTY(unsigned generation MEMBER generation)
-    Q_PROPERTY(QVariantList peepsPositions MEMBER peepsPositions)
     Q_PROPERTY(QVariantList barrierLocs MEMBER barrierLocs)
-    Q_PROPERTY(QVariantList peepsColors MEMBER peepsColors)
+    Q_PROPERTY(unsigned signalLayerCount MEMBER signalLayerCount)
 };
 
 class Backend : public QObject
@@ -50,6 +69,8 @@ public:
 
     //! Returns the world size.
     std::pair<uint16_t, uint16_t> GetFrameSize() const;
+    //! Returns the file the trajectory of \a generation is saved to, see Parameters::saveTrajectories.
+    std::string GetTrajectoryPath(unsigned generation) const;
     //! Stops the work.
     Q_INVOKABLE void StopThread() { m_ThreadStop = true; }
     //! Returns the current challenge id.
@@ -86,6 +107,8 @@ public:
     std::pair<unsigned, std::vector<float> > GetGeneticDiversity() const;
     //! Returns the vector of completing peeps counts for each challenge task not sent out yet alongside the last processed index.
     std::pair<unsigned, std::vector<std::vector<unsigned> > > GetCompletedChallengeTaskCounts() const;
+    //! Returns the vectors of avg sim step times and generation turnover times not sent out yet alongside the last processed index.
+    std::pair<unsigned, std::vector<std::vector<float> > > GetGenerationTimes() const;
     //! Returns the available analytics types.
     std::vector<std::string> GetAnalyticsTypes() const;
     //! Clears all processed counts in analytics.
@@ -101,6 +124,12 @@ public slots:
 
     //! Returns the world data.
     WorldData GetWorldData();
+    //! Copies the living peeps of the last sim step to \a sprites.
+    void GetPeepSprites(std::vector<PeepSprite>& sprites);
+    //! Returns a layer of the last published pheromone frame as a grayscale image, wrapping
+    //! the published buffer without copying. One scanline per world column, x major.
+    //! Also requests a new frame, published at the end of the next sim step.
+    QImage GetSignalLayerImage(unsigned layer);
 
 private:
     /**********************************************************************************************
@@ -160,17 +189,24 @@ private:
     bool                                              m_ThreadStop{false};  ///!< When set to true stop the work.
     WorldData                                         m_WorldData{};        ///< Contains the world data for the current sim step.
                                                                             ///< Processed by an external thread (for example UI)
+    std::atomic<bool>                                 m_SignalFrameRequested{false}; ///< Set by the UI to get the pheromone layers published.
 
     std::unique_ptr<RandomUintGenerator>              m_xRandomGenerator{}; ///< Random number generator
     std::unique_ptr<ParameterIO>                      m_xParameterIO{};     ///< Parameter IO handler
     std::unique_ptr<Grid>                             m_xGrid{};            ///< World grid manager
     std::unique_ptr<PheromoneSignals>                 m_xSignals{};         ///< Pheromon signal manager
     std::unique_ptr<Sensors>                          m_xSensors{};         ///< Sensors manager
+    std::unique_ptr<SensorFields>                     m_xSensorFields{};    ///< Precomputed neighborhood sensor fields
+    std::unique_ptr<SensorPyramids>                   m_xSensorPyramids{};  ///< Pyramids of the long-radius sensors
+    std::unique_ptr<SpatialOrder>                     m_xSpatialOrder{};    ///< Peep iteration order
     std::unique_ptr<PeepsPool>                        m_xPeeps{};           ///< Peeps life cycle manager
     std::unique_ptr<Actions>                          m_xActions{};         ///< Peep actions manager
     std::unique_ptr<Challenges::iChallenge>           m_xChallenge{};       ///< Holds the current challenge
     std::unique_ptr<Analytics>                        m_xAnalytics{};       ///< Analytics manager
+    std::unique_ptr<FrameRecorder>                    m_xFrameRecorder{};   ///< Generation movie recorder
+    std::unique_ptr<TrajectoryRecorder>               m_xTrajectoryRecorder{};  ///< Generation trajectory recorder
     std::unique_ptr<GenerationGenerator>              m_xGenerationGenerator{};                     ///< Handles generation evaluation and regeneration
+    std::unique_ptr<Checkpoint>                       m_xCheckpoint{};                              ///< Saves and restores the simulation state
     std::unique_ptr<SysStateMachine>                  m_xSysStateMachine{};                         ///< System state machine
     Analytics::eType                                  m_AnalyticsType{Analytics::eType::Survivors}; ///< Holds the current active analytics type
     eChallenges                                       m_CurrentChallenge{eChallenges::Altruism};    ///< Holds the current active challenge type
@@ -14,7 +14,7 @@ Circle::Circle(const Coord& center, float radius)
 }
 
 //-------------------------------------------------------------------------
-void Circle::Draw(uint16_t barrierMask, const Parameters& params, Grid& grid)
+void Circle::Draw(PeepIndex barrierMask, const Parameters& params, Grid& grid)
 {
     auto f = [&](Coord loc) {
         grid.set(loc, barrierMask);
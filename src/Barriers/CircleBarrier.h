@@ -17,7 +17,7 @@ public:
         float radius;
     };
 
-    void Draw(uint16_t barrierMask, const Parameters& params, Grid& grid) override;
+    void Draw(PeepIndex barrierMask, const Parameters& params, Grid& grid) override;
 
     Setup& GetSetup() { return m_Setup; };
 private:
@@ -16,7 +16,7 @@ Rectangle::Rectangle(const Coord& topLeft, uint16_t width, uint16_t height)
 }
 
 //-------------------------------------------------------------------------
-void Rectangle::Draw(uint16_t barrierMask, const Parameters&, Grid& grid)
+void Rectangle::Draw(PeepIndex barrierMask, const Parameters&, Grid& grid)
 {
     for (int16_t x = m_Setup.topLeft.x; x <= m_Setup.topLeft.x + m_Setup.width; ++x) {
         for (int16_t y = m_Setup.topLeft.y; y <= m_Setup.topLeft.y + m_Setup.height; ++y) {
@@ -18,7 +18,7 @@ public:
         uint16_t height;
     };
 
-    void Draw(uint16_t barrierMask, const Parameters& params, Grid& grid) override;
+    void Draw(PeepIndex barrierMask, const Parameters& params, Grid& grid) override;
 
     Setup& GetSetup() { return m_Setup; };
 private:
@@ -101,4 +101,11 @@ void createBarrier(
     }
 }
 
+//-------------------------------------------------------------------------
+bool hasRandomLayout(eBarrierType barrierType)
+{
+    return barrierType == eBarrierType::VerticalBarRandomLoc ||
+           barrierType == eBarrierType::ThreeFloatingIslands;
+}
+
 } // namespace Barriers
\ No newline at end of file
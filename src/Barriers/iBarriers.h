@@ -1,5 +1,7 @@
 #pragma once
 
+#include "BasicTypes.h"
+
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -26,7 +28,7 @@ namespace Barriers
 class iBarrier
 {
 public:
-  virtual void Draw(uint16_t barrierMask, const Parameters& params, Grid& grid) = 0;
+  virtual void Draw(PeepIndex barrierMask, const Parameters& params, Grid& grid) = 0;
 };
 
 //! Sets the content of \a barriers with the appropriate barrier types.
@@ -36,4 +38,7 @@ void createBarrier(
     RandomUintGenerator& random,
     const Parameters& params);
 
+//! Returns true if createBarrier() places the barriers of the type at random locations.
+bool hasRandomLayout(eBarrierType barrierType);
+
 } // namespace Barriers
\ No newline at end of file
@@ -53,6 +53,15 @@ Arithmetic
     Polar = Polar * Polar (dot product)
 */
 
+//! Peep index stored in the grid cells. 16-bit by default, which limits the population
+//! to 65534 (0 and the max value are reserved). Build with -DPEEP_INDEX_32BIT=ON for
+//! larger populations, at twice the grid and queue memory.
+#ifdef PEEP_INDEX_32BIT
+using PeepIndex = uint32_t;
+#else
+using PeepIndex = uint16_t;
+#endif
+
 //! Defines compass directions
 enum class Compass : uint8_t 
 { 
@@ -24,7 +24,7 @@ Altruism::Altruism(RandomUintGenerator& random, const Parameters& params)
 }
 
 //-------------------------------------------------------------------------
-std::vector<std::pair<uint16_t, float> >& Altruism::EvaluateWhenNewGeneration(
+std::vector<std::pair<PeepIndex, float> >& Altruism::EvaluateWhenNewGeneration(
     const PeepsPool& peeps,
     const Parameters& params,
     const Grid& grid,
@@ -36,11 +36,11 @@ std::vector<std::pair<uint16_t, float> >& Altruism::EvaluateWhenNewGeneration(
     // For the altruism challenge, test if the agent is inside either the sacrificial
     // or the spawning area. We'll count the number in the sacrificial area and
     // save the genomes of the ones in the spawning area, saving their scores
-    // for later sorting. Indexes start at 1.
+    // for later sorting. Only the living peeps can pass.
     bool considerKinship = true;
-    std::vector<uint16_t> sacrificesIndexes; // those who gave their lives for the greater good
+    std::vector<PeepIndex> sacrificesIndexes; // those who gave their lives for the greater good
 
-    for (uint16_t index = 1; index <= params.population; ++index) {
+    for (PeepIndex index : peeps.livePeeps()) {
         // This the test for the spawning area:
         std::pair<bool, float> passed = PassedCriteria(peeps[index], params, grid);
         if (passed.first && !peeps[index].nnet.connections.empty()) {
@@ -67,13 +67,13 @@ std::vector<std::pair<uint16_t, float> >& Altruism::EvaluateWhenNewGeneration(
             // Todo: optimize!!!
             float threshold = 0.7;
 
-            std::vector<std::pair<uint16_t, float>> survivingKin;
+            std::vector<std::pair<PeepIndex, float>> survivingKin;
             for (unsigned passes = 0; passes < altruismFactor; ++passes) {
-                for (uint16_t sacrificedIndex : sacrificesIndexes) {
+                for (PeepIndex sacrificedIndex : sacrificesIndexes) {
                     // randomize the next loop so we don't keep using the first one repeatedly
                     unsigned startIndex = m_Random(0, parents.size() - 1);
                     for (unsigned count = 0; count < parents.size(); ++count) {
-                        const std::pair<uint16_t, float> &possibleParent = parents[(startIndex + count) % parents.size()];
+                        const std::pair<PeepIndex, float> &possibleParent = parents[(startIndex + count) % parents.size()];
                         const Genetics::Genome &g1 = peeps[sacrificedIndex].genome;
                         const Genetics::Genome &g2 = peeps[possibleParent.first].genome;
                         float similarity = Genetics::genomeSimilarity(g1, g2, params);
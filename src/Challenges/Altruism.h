@@ -21,7 +21,7 @@ public:
 
     Altruism(RandomUintGenerator& random, const Parameters& params);
 
-    std::vector<std::pair<uint16_t, float> >& EvaluateWhenNewGeneration(
+    std::vector<std::pair<PeepIndex, float> >& EvaluateWhenNewGeneration(
         const PeepsPool& peeps,
         const Parameters& params,
         const Grid& grid,
@@ -31,7 +31,7 @@ CircularSequence::CircularSequence(const Parameters& params, Analytics& analytic
 }
 
 //-------------------------------------------------------------------------
-std::vector<std::pair<uint16_t, float> >& CircularSequence::EvaluateWhenNewGeneration(
+std::vector<std::pair<PeepIndex, float> >& CircularSequence::EvaluateWhenNewGeneration(
     const PeepsPool& peeps,
     const Parameters& params,
     const Grid& grid,
@@ -87,7 +87,8 @@ void CircularSequence::EvaluateAtEndOfSimStep(
     const Grid&,
     const Settings&)
 {
-    for (uint16_t index = 1; index <= params.population; ++index) { // index 0 is reserved
+    // Killed peeps keep collecting bits at their last location, see PassesDeadPeeps().
+    for (PeepIndex index = 1; index <= params.population; ++index) { // index 0 is reserved
         Peep &peep = peeps[index];
         auto inAnyChallengeCircle = false;
         for (unsigned n = 0; n < m_Setup.centers.size(); ++n) {
@@ -37,7 +37,7 @@ public:
     std::pair<bool, float> PassedCriteria(const Peep& peep, const Parameters& params, const Grid& grid) override;
 
 
-    std::vector<std::pair<uint16_t, float> >& EvaluateWhenNewGeneration(
+    std::vector<std::pair<PeepIndex, float> >& EvaluateWhenNewGeneration(
         const PeepsPool& peeps,
         const Parameters& params,
         const Grid& grid,
@@ -45,6 +45,10 @@ public:
 
     const Setup& GetSetup() const { return m_Setup; }
 
+protected:
+    //! Killed peeps keep their challenge bits and can pass.
+    bool PassesDeadPeeps() const override { return true; }
+
 private:
     Setup m_Setup{};
     Analytics& m_Analytics;
@@ -41,7 +41,8 @@ void LocationSequence::EvaluateAtEndOfSimStep(
     const Settings&)
 {
     float radius = 15.0;
-    for (uint16_t index = 1; index <= params.population; ++index) { // index 0 is reserved
+    // Killed peeps keep collecting bits at their last location, see PassesDeadPeeps().
+    for (PeepIndex index = 1; index <= params.population; ++index) { // index 0 is reserved
         Peep &peep = peeps[index];
         for (unsigned n = 0; n < grid.getBarrierCenters().size(); ++n) {
             unsigned bit = 1 << n;
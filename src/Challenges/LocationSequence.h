@@ -25,6 +25,10 @@ public:
     //! \copydoc iChallenge::PassedCriteria
     std::pair<bool, float> PassedCriteria(const Peep& peep, const Parameters&, const Grid&) override;
 
+protected:
+    //! Killed peeps keep their challenge bits and can pass.
+    bool PassesDeadPeeps() const override { return true; }
+
 private:
     const Parameters& m_Params;
 };
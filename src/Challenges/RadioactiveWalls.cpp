@@ -36,12 +36,12 @@ void RadioactiveWalls::EvaluateAtEndOfSimStep(
     auto condition = (settings.simStep < params.stepsPerGeneration / 2);
     int16_t radioactiveX =  condition ? 0 : params.sizeX - 1;
     m_Setup.border = condition ? 0 : 2;
-    for (uint16_t index = 1; index <= params.population; ++index) { // index 0 is reserved
+    for (PeepIndex index : peeps.livePeeps()) {
         Peep &peep = peeps[index];
         int16_t distanceFromRadioactiveWall = std::abs(peep.loc.x - radioactiveX);
         if (distanceFromRadioactiveWall < static_cast<int16_t>(m_Setup.distance)) {
             float chanceOfDeath = 1.0 / distanceFromRadioactiveWall;
-            if (m_Random() / (float)RANDOM_UINT_MAX < chanceOfDeath) {
+            if (m_Random.uniform() < chanceOfDeath) {
                 peeps.queueForDeath(peep);
             }
         }
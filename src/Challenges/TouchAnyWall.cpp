@@ -37,7 +37,7 @@ void TouchAnyWall::EvaluateAtEndOfSimStep(
     const Grid&,
     const Settings&)
 {
-    for (uint16_t index = 1; index <= params.population; ++index) { // index 0 is reserved
+    for (PeepIndex index : peeps.livePeeps()) {
         Peep &peep = peeps[index];
         if (peep.loc.x == 0 || peep.loc.x == params.sizeX - 1
           || peep.loc.y == 0 || peep.loc.y == params.sizeY - 1) {
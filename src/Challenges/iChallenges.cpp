@@ -32,7 +32,7 @@ namespace Challenges
 {
 
 //-------------------------------------------------------------------------
-std::vector<std::pair<uint16_t, float> >& iChallenge::EvaluateWhenNewGeneration(        
+std::vector<std::pair<PeepIndex, float> >& iChallenge::EvaluateWhenNewGeneration(        
         const PeepsPool& peeps,
         const Parameters& params,
         const Grid& grid,
@@ -40,8 +40,8 @@ std::vector<std::pair<uint16_t, float> >& iChallenge::EvaluateWhenNewGeneration(
 {
     m_Parents.clear();
     // First, make a list of all the peeps who will become parents; save
-    // their scores for later sorting. Indexes start at 1.
-    for (uint16_t index = 1; index <= params.population; ++index) {
+    // their scores for later sorting.
+    auto evaluate = [&](PeepIndex index) {
         std::pair<bool, float> passed = PassedCriteria(peeps[index], params, grid);
         // Save the parent genome if it results in valid neural connections
         // ToDo: if the parents no longer need their genome record, we could
@@ -50,6 +50,15 @@ std::vector<std::pair<uint16_t, float> >& iChallenge::EvaluateWhenNewGeneration(
         if (passed.first && !peeps[index].nnet.connections.empty()) {
             m_Parents.push_back( { index, passed.second } );
         }
+    };
+    if (PassesDeadPeeps()) {
+        for (PeepIndex index = 1; index <= params.population; ++index) { // index 0 is reserved
+            evaluate(index);
+        }
+    } else {
+        for (PeepIndex index : peeps.livePeeps()) {
+            evaluate(index);
+        }
     }
     return m_Parents;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "BasicTypes.h"
+
 #include <memory>
 #include <vector>
 
@@ -54,7 +56,7 @@ class iChallenge
 public:
     //! Evaluates challenge on all the peeps at the beginning of a new generation.
     //! \return the list of parents survived the challenge.
-    virtual std::vector<std::pair<uint16_t, float> >& EvaluateWhenNewGeneration(
+    virtual std::vector<std::pair<PeepIndex, float> >& EvaluateWhenNewGeneration(
         const PeepsPool& peeps,
         const Parameters& params,
         const Grid& grid,
@@ -73,12 +75,16 @@ protected:
     //! \return true and a score 0.0..1.0 if passed, false if failed.
     virtual std::pair<bool, float> PassedCriteria(const Peep& peep, const Parameters& params, const Grid& grid) = 0;
 
+    //! Whether PassedCriteria() passes peeps that were killed during the generation.
+    //! EvaluateWhenNewGeneration() scans all indexes then, otherwise the living peeps only.
+    virtual bool PassesDeadPeeps() const { return false; }
+
     //! Returns the surviveing parents.
-    std::vector<std::pair<uint16_t, float> >& GetParents() { return m_Parents; }
+    std::vector<std::pair<PeepIndex, float> >& GetParents() { return m_Parents; }
 private:
     //! This container will hold the indexes and survival scores (0.0..1.0)
     //! of all the survivors who will provide genomes for repopulation.
-    std::vector<std::pair<uint16_t, float> > m_Parents; // <peep index, score>
+    std::vector<std::pair<PeepIndex, float> > m_Parents; // <peep index, score>
 };
 
 //! Evaluates the seletced challenge on all the peeps.
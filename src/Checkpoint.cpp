@@ -0,0 +1,662 @@
+#include "Checkpoint.h"
+
+#include "Analytics.h"
+#include "GenerationGenerator.h"
+#include "Grid.h"
+#include "Parameters.h"
+#include "PeepsPool.h"
+#include "PheromoneSignals.h"
+#include "Random.h"
+#include "SensorsActions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/wait.h>
+#endif
+
+namespace
+{
+    constexpr char cMagic[8] = {'G', 'O', 'E', 'V', 'C', 'K', 'P', 'T'};
+
+    enum Section : unsigned {
+        RandomState,        ///< RandomUintGenerator::State
+        SensorTypes,        ///< uint8 per available sensor type
+        ActionTypes,        ///< uint8 per available action type
+        PeepRecords,        ///< PeepRecord per peep, indexes 1..population
+        Genes,              ///< Genetics::Gene of all genomes
+        NeuronOutputs,      ///< float per neuron of all neural nets
+        GridCells,          ///< PeepIndex per cell, column major
+        BarrierCenters,     ///< Coord per barrier center
+        SignalCells,        ///< uint8 per cell and layer, see PheromoneSignals::copyLayer()
+        AnalyticsHistory,   ///< uint64 count and the values of each Analytics vector
+        LineageIds,         ///< uint64 next lineage id, uint64 per peep if recorded, see PhylogenyRecorder
+        SectionCount
+    };
+
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t peepIndexSize;
+        uint32_t generation;        ///< The generation to run after the restore.
+        uint32_t population;
+        uint32_t sizeX;
+        uint32_t sizeY;
+        uint32_t signalLayers;
+        uint32_t challenge;
+        uint32_t oldestAge;
+        uint32_t reserved;
+        SectionEntry sections[SectionCount];
+    };
+
+    struct PeepRecord {
+        uint64_t geneOffset;        ///< Index of the first gene in Genes.
+        uint64_t neuronOffset;      ///< Index of the first output in NeuronOutputs.
+        uint32_t geneCount;
+        uint32_t neuronCount;
+        uint32_t plannedSimStep;
+        uint32_t planTimeUpdateStep;
+        uint32_t age;
+        uint32_t oscPeriod;
+        uint32_t longProbeDist;
+        uint32_t challengeBits;
+        float responsiveness;
+        int16_t locX;
+        int16_t locY;
+        int16_t birthLocX;
+        int16_t birthLocY;
+        int16_t plannedLocX;
+        int16_t plannedLocY;
+        uint8_t alive;
+        uint8_t survivedToNextGen;
+        uint8_t lastMoveDir;
+        uint8_t reserved;
+    };
+
+    static_assert(sizeof(PeepRecord) == 72, "The peep records are part of the file format");
+    static_assert(sizeof(Genetics::Gene) == 4, "The genes are part of the file format");
+    static_assert(sizeof(Coord) == 4, "The barrier centers are part of the file format");
+
+    //! A file written with system calls only, see Checkpoint::WriteFile().
+    class RawFile
+    {
+    public:
+        explicit RawFile(const char* path)
+            : m_Fd(open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644))
+        {
+
+        }
+
+        ~RawFile()
+        {
+            if (m_Fd >= 0) {
+                close(m_Fd);
+            }
+        }
+
+        bool IsOpen() const { return m_Fd >= 0; }
+        uint64_t Position() const { return m_Position; }
+
+        bool Write(const void* pData, size_t size)
+        {
+            const char* pBytes = static_cast<const char*>(pData);
+            while (size > 0) {
+                const ssize_t written = write(m_Fd, pBytes, size);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (written <= 0) {
+                    return false;
+                }
+                pBytes += written;
+                size -= written;
+                m_Position += written;
+            }
+            return true;
+        }
+
+        //! Writes zeros up to \a offset.
+        bool PadTo(uint64_t offset)
+        {
+            static const char zeros[64] = {};
+            while (m_Position < offset) {
+                if (!Write(zeros, std::min<uint64_t>(sizeof(zeros), offset - m_Position))) {
+                    return false;
+                }
+            }
+            return m_Position == offset;
+        }
+
+        //! Flushes the file to the disk and closes it.
+        bool Close()
+        {
+            const bool synced = fsync(m_Fd) == 0;
+            const bool closed = close(m_Fd) == 0;
+            m_Fd = -1;
+            return synced && closed;
+        }
+
+    private:
+        int m_Fd;
+        uint64_t m_Position{};
+    };
+}
+
+//-------------------------------------------------------------------------
+Checkpoint::Checkpoint(
+    Grid& grid,
+    PeepsPool& peepsPool,
+    PheromoneSignals& pheromones,
+    Analytics& analytics,
+    Sensors& sensors,
+    Actions& actions,
+    GenerationGenerator& generationGenerator,
+    RandomUintGenerator& random,
+    const Parameters& params,
+    std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers)
+    : m_Grid(grid)
+    , m_PeepsPool(peepsPool)
+    , m_PheromoneSignals(pheromones)
+    , m_Analytics(analytics)
+    , m_Sensors(sensors)
+    , m_Actions(actions)
+    , m_GenerationGenerator(generationGenerator)
+    , m_Random(random)
+    , m_Params(params)
+    , m_Barriers(barriers)
+{
+
+}
+
+//-------------------------------------------------------------------------
+Checkpoint::~Checkpoint()
+{
+    PollSnapshots(true);
+}
+
+//-------------------------------------------------------------------------
+bool Checkpoint::Save(const std::string& path, unsigned generation, unsigned challenge)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    // The store must hold all births the checkpoint refers to.
+    m_GenerationGenerator.GetPhylogeny().Flush();
+#if defined(__linux__)
+    if (m_Params.checkpointSnapshots > 0) {
+        return SaveSnapshot(path, generation, challenge);
+    }
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    const std::string tempPath = path + ".tmp";
+    Prepare(generation, challenge);
+    if (!WriteFile(tempPath)) {
+        std::cerr << "Couldn't write checkpoint " << tempPath << "." << std::endl;
+        return false;
+    }
+    if (!Commit(tempPath, path)) {
+        return false;
+    }
+    m_CommittedSequence = ++m_Sequence;
+    std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Saved checkpoint of generation " << generation << " to " << path
+              << ", the sim thread paused " << duration.count() << " ms." << std::endl;
+    return true;
+}
+
+#if defined(__linux__)
+//-------------------------------------------------------------------------
+bool Checkpoint::SaveSnapshot(const std::string& path, unsigned generation, unsigned challenge)
+{
+    PollSnapshots(false);
+    if (m_Snapshots.size() >= m_Params.checkpointSnapshots) {
+        std::cout << "Skipped the checkpoint of generation " << generation << ", "
+                  << m_Snapshots.size() << " snapshot processes are still writing." << std::endl;
+        return false;
+    }
+
+    const unsigned sequence = ++m_Sequence;
+    const std::string tempPath = path + ".snapshot" + std::to_string(sequence);
+    auto start = std::chrono::steady_clock::now();
+    Prepare(generation, challenge);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // Only this thread exists in the child, the other threads may have held the locks of
+        // the allocator or the streams at the fork. The child writes from its copy-on-write
+        // view of the state with system calls only and leaves without running any destructors.
+        _exit(WriteFile(tempPath) ? 0 : 1);
+    }
+    std::chrono::duration<float, std::milli> pause = std::chrono::steady_clock::now() - start;
+    if (pid < 0) {
+        std::cerr << "Couldn't fork a snapshot process for generation " << generation << "." << std::endl;
+        return false;
+    }
+    m_Snapshots.push_back({pid, sequence, generation, tempPath, path, start});
+    std::cout << "Forked a snapshot process for the checkpoint of generation " << generation
+              << ", the sim thread paused " << pause.count() << " ms." << std::endl;
+    return true;
+}
+#endif
+
+//-------------------------------------------------------------------------
+void Checkpoint::PollSnapshots(bool wait)
+{
+#if defined(__linux__)
+    for (auto it = m_Snapshots.begin(); it != m_Snapshots.end(); ) {
+        int status = 0;
+        const pid_t result = waitpid(it->pid, &status, wait ? 0 : WNOHANG);
+        if (result == 0) {
+            ++it;
+            continue;
+        }
+        std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - it->start;
+        std::error_code error;
+        if (result != it->pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "The snapshot process for the checkpoint of generation " << it->generation << " failed." << std::endl;
+            std::filesystem::remove(it->tempPath, error);
+        } else if (it->sequence < m_CommittedSequence) {
+            // A later snapshot finished first.
+            std::filesystem::remove(it->tempPath, error);
+        } else if (Commit(it->tempPath, it->path)) {
+            m_CommittedSequence = it->sequence;
+            std::cout << "Saved checkpoint of generation " << it->generation << " to " << it->path
+                      << ", the snapshot process took " << duration.count() << " ms." << std::endl;
+        }
+        it = m_Snapshots.erase(it);
+    }
+#else
+    (void)wait;
+#endif
+}
+
+//-------------------------------------------------------------------------
+bool Checkpoint::Commit(const std::string& tempPath, const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "Couldn't rename " << tempPath << " to " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+void Checkpoint::Prepare(unsigned generation, unsigned challenge)
+{
+    Header header{};
+    std::copy(std::begin(cMagic), std::end(cMagic), header.magic);
+    header.version = cVersion;
+    header.peepIndexSize = sizeof(PeepIndex);
+    header.generation = generation;
+    header.population = m_Params.population;
+    header.sizeX = m_Grid.sizeX();
+    header.sizeY = m_Grid.sizeY();
+    header.signalLayers = m_PheromoneSignals.layerCount();
+    header.challenge = challenge;
+    header.oldestAge = m_GenerationGenerator.GetOldestAge();
+
+    std::vector<PeepRecord> records(m_Params.population);
+    uint64_t geneCount = 0;
+    uint64_t neuronCount = 0;
+    for (unsigned index = 1; index <= m_Params.population; ++index) {
+        const Peep& peep = m_PeepsPool[index];
+        PeepRecord& record = records[index - 1];
+        record.geneOffset = geneCount;
+        record.neuronOffset = neuronCount;
+        record.geneCount = peep.genome.size();
+        record.neuronCount = peep.nnet.neurons.size();
+        record.plannedSimStep = peep.plannedSimStep;
+        record.planTimeUpdateStep = peep.planTimeUpdateStep;
+        record.age = peep.age;
+        record.oscPeriod = peep.oscPeriod;
+        record.longProbeDist = peep.longProbeDist;
+        record.challengeBits = peep.challengeBits;
+        record.responsiveness = peep.responsiveness;
+        record.locX = peep.loc.x;
+        record.locY = peep.loc.y;
+        record.birthLocX = peep.birthLoc.x;
+        record.birthLocY = peep.birthLoc.y;
+        record.plannedLocX = peep.plannedLoc.x;
+        record.plannedLocY = peep.plannedLoc.y;
+        record.alive = peep.alive;
+        record.survivedToNextGen = peep.survivedToNextGen;
+        record.lastMoveDir = peep.lastMoveDir.asInt();
+        geneCount += record.geneCount;
+        neuronCount += record.neuronCount;
+    }
+
+    auto vectorSize = [](const auto& values) { return sizeof(uint64_t) + values.size() * sizeof(values[0]); };
+    uint64_t analyticsSize = vectorSize(m_Analytics.m_Survivors) + vectorSize(m_Analytics.m_GeneticDiversity)
+        + sizeof(uint64_t) + sizeof(uint32_t)
+        + vectorSize(m_Analytics.m_AvgAge) + vectorSize(m_Analytics.m_SurvivorsToNextGen)
+        + vectorSize(m_Analytics.m_StepTimes) + vectorSize(m_Analytics.m_TurnoverTimes);
+    for (const auto& row : m_Analytics.m_CompletedChallengeTasks) {
+        analyticsSize += vectorSize(row);
+    }
+
+    const size_t layerSize = size_t(m_Grid.sizeX()) * m_Grid.sizeY();
+    const uint64_t sizes[SectionCount] = {
+        sizeof(RandomUintGenerator::State),
+        m_Sensors.AvailableTypes().size(),
+        m_Actions.AvailableTypes().size(),
+        records.size() * sizeof(PeepRecord),
+        geneCount * sizeof(Genetics::Gene),
+        neuronCount * sizeof(float),
+        layerSize * sizeof(PeepIndex),
+        m_Grid.getBarrierCenters().size() * sizeof(Coord),
+        layerSize * m_PheromoneSignals.layerCount(),
+        analyticsSize,
+        sizeof(uint64_t) + m_GenerationGenerator.GetPhylogeny().Ids().size() * sizeof(uint64_t)
+    };
+    uint64_t offset = sizeof(Header);
+    for (unsigned section = 0; section < SectionCount; ++section) {
+        offset += (cAlignment - offset % cAlignment) % cAlignment;
+        header.sections[section] = {offset, sizes[section]};
+        offset += sizes[section];
+    }
+
+    // The sections up to the peep records are written with the header.
+    m_Prefix.assign(header.sections[PeepRecords].offset + header.sections[PeepRecords].size, 0);
+    std::memcpy(m_Prefix.data(), &header, sizeof(header));
+    const RandomUintGenerator::State randomState = m_Random.state();
+    std::memcpy(&m_Prefix[header.sections[RandomState].offset], &randomState, sizeof(randomState));
+    uint8_t* pSensorTypes = &m_Prefix[header.sections[SensorTypes].offset];
+    for (Sensors::eType type : m_Sensors.AvailableTypes()) {
+        *pSensorTypes++ = type;
+    }
+    uint8_t* pActionTypes = &m_Prefix[header.sections[ActionTypes].offset];
+    for (Actions::eType type : m_Actions.AvailableTypes()) {
+        *pActionTypes++ = type;
+    }
+    std::memcpy(&m_Prefix[header.sections[PeepRecords].offset], records.data(), records.size() * sizeof(PeepRecord));
+
+    m_LayerBuffer.resize(layerSize * sizeof(PeepIndex));
+}
+
+//-------------------------------------------------------------------------
+bool Checkpoint::WriteFile(const std::string& filePath)
+{
+    Header header;
+    std::memcpy(&header, m_Prefix.data(), sizeof(header));
+    RawFile file(filePath.c_str());
+    bool valid = file.IsOpen();
+
+    auto write = [&](const void* pData, size_t size) {
+        valid = valid && file.Write(pData, size);
+    };
+    auto writeVector = [&write](const auto& values) {
+        const uint64_t count = values.size();
+        write(&count, sizeof(count));
+        write(values.data(), count * sizeof(values[0]));
+    };
+    // Each section has to end where Prepare() laid it out.
+    auto beginSection = [&](Section section) {
+        valid = valid && file.PadTo(header.sections[section].offset);
+    };
+    auto endSection = [&](Section section) {
+        valid = valid && file.Position() == header.sections[section].offset + header.sections[section].size;
+    };
+
+    write(m_Prefix.data(), m_Prefix.size());
+
+    beginSection(Genes);
+    for (unsigned index = 1; valid && index <= m_Params.population; ++index) {
+        const Genetics::Genome& genome = m_PeepsPool[index].genome;
+        write(genome.data(), genome.size() * sizeof(Genetics::Gene));
+    }
+    endSection(Genes);
+
+    beginSection(NeuronOutputs);
+    constexpr unsigned cOutputBatch = 1024;
+    float outputs[cOutputBatch];
+    unsigned outputCount = 0;
+    for (unsigned index = 1; valid && index <= m_Params.population; ++index) {
+        for (const auto& neuron : m_PeepsPool[index].nnet.neurons) {
+            outputs[outputCount++] = neuron.output;
+            if (outputCount == cOutputBatch) {
+                write(outputs, sizeof(outputs));
+                outputCount = 0;
+            }
+        }
+    }
+    write(outputs, outputCount * sizeof(float));
+    endSection(NeuronOutputs);
+
+    const size_t layerSize = size_t(m_Grid.sizeX()) * m_Grid.sizeY();
+    beginSection(GridCells);
+    m_Grid.copyCells(reinterpret_cast<PeepIndex*>(m_LayerBuffer.data()));
+    write(m_LayerBuffer.data(), layerSize * sizeof(PeepIndex));
+    endSection(GridCells);
+
+    beginSection(BarrierCenters);
+    write(m_Grid.getBarrierCenters().data(), m_Grid.getBarrierCenters().size() * sizeof(Coord));
+    endSection(BarrierCenters);
+
+    beginSection(SignalCells);
+    for (uint16_t layerNum = 0; valid && layerNum < m_PheromoneSignals.layerCount(); ++layerNum) {
+        m_PheromoneSignals.copyLayer(layerNum, m_LayerBuffer.data());
+        write(m_LayerBuffer.data(), layerSize);
+    }
+    endSection(SignalCells);
+
+    beginSection(AnalyticsHistory);
+    writeVector(m_Analytics.m_Survivors);
+    writeVector(m_Analytics.m_GeneticDiversity);
+    const uint64_t taskRows = m_Analytics.m_CompletedChallengeTasks.size();
+    write(&taskRows, sizeof(taskRows));
+    for (const auto& row : m_Analytics.m_CompletedChallengeTasks) {
+        writeVector(row);
+    }
+    const uint32_t taskCount = m_Analytics.m_ChallengeTaskCount;
+    write(&taskCount, sizeof(taskCount));
+    writeVector(m_Analytics.m_AvgAge);
+    writeVector(m_Analytics.m_SurvivorsToNextGen);
+    writeVector(m_Analytics.m_StepTimes);
+    writeVector(m_Analytics.m_TurnoverTimes);
+    endSection(AnalyticsHistory);
+
+    beginSection(LineageIds);
+    const PhylogenyRecorder& phylogeny = m_GenerationGenerator.GetPhylogeny();
+    const uint64_t nextId = phylogeny.NextId();
+    write(&nextId, sizeof(nextId));
+    write(phylogeny.Ids().data(), phylogeny.Ids().size() * sizeof(uint64_t));
+    endSection(LineageIds);
+
+    if (file.IsOpen()) {
+        valid = file.Close() && valid;
+    }
+    return valid;
+}
+
+//-------------------------------------------------------------------------
+bool Checkpoint::Restore(const std::string& path, unsigned& generation, unsigned challenge)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cout << "No checkpoint at " << path << ", starting from generation 0." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> buffer(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+
+    // Check everything before the first change of the state.
+    Header header{};
+    bool valid = file && buffer.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        valid = std::equal(std::begin(cMagic), std::end(cMagic), header.magic) && header.version == cVersion;
+        for (unsigned section = 0; valid && section < SectionCount; ++section) {
+            valid = header.sections[section].offset % cAlignment == 0
+                && header.sections[section].offset <= buffer.size()
+                && header.sections[section].size <= buffer.size() - header.sections[section].offset;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Invalid checkpoint " << path << "." << std::endl;
+        return false;
+    }
+    if (header.peepIndexSize != sizeof(PeepIndex) || header.population != m_Params.population
+        || header.sizeX != m_Grid.sizeX() || header.sizeY != m_Grid.sizeY()
+        || header.signalLayers != m_PheromoneSignals.layerCount()) {
+        std::cerr << "Checkpoint " << path << " does not match the world size, the population, "
+                  << "the signal layers or the peep index width." << std::endl;
+        return false;
+    }
+    if (header.challenge != challenge) {
+        std::cout << "Checkpoint " << path << " was saved with challenge " << header.challenge
+                  << ", continuing with challenge " << challenge << "." << std::endl;
+    }
+
+    auto sectionData = [&](Section section) { return &buffer[header.sections[section].offset]; };
+    auto sectionSize = [&](Section section) { return header.sections[section].size; };
+    const size_t layerSize = size_t(header.sizeX) * header.sizeY;
+    const uint64_t geneCount = sectionSize(Genes) / sizeof(Genetics::Gene);
+    const uint64_t outputCount = sectionSize(NeuronOutputs) / sizeof(float);
+    valid = sectionSize(RandomState) == sizeof(RandomUintGenerator::State)
+        && sectionSize(PeepRecords) == uint64_t(header.population) * sizeof(PeepRecord)
+        && sectionSize(GridCells) == layerSize * sizeof(PeepIndex)
+        && sectionSize(SignalCells) == layerSize * header.signalLayers
+        && sectionSize(BarrierCenters) % sizeof(Coord) == 0
+        && (sectionSize(LineageIds) == sizeof(uint64_t)
+            || sectionSize(LineageIds) == (uint64_t(header.population) + 2) * sizeof(uint64_t));
+
+    std::vector<Sensors::eType> sensorTypes;
+    for (uint64_t n = 0; valid && n < sectionSize(SensorTypes); ++n) {
+        valid = sectionData(SensorTypes)[n] < Sensors::NUM_SENSES;
+        sensorTypes.push_back(static_cast<Sensors::eType>(sectionData(SensorTypes)[n]));
+    }
+    std::vector<Actions::eType> actionTypes;
+    for (uint64_t n = 0; valid && n < sectionSize(ActionTypes); ++n) {
+        valid = sectionData(ActionTypes)[n] < Actions::NUM_ACTIONS;
+        actionTypes.push_back(static_cast<Actions::eType>(sectionData(ActionTypes)[n]));
+    }
+
+    const auto* pRecords = reinterpret_cast<const PeepRecord*>(sectionData(PeepRecords));
+    for (unsigned n = 0; valid && n < header.population; ++n) {
+        valid = pRecords[n].geneCount > 0
+            && pRecords[n].geneOffset <= geneCount && pRecords[n].geneCount <= geneCount - pRecords[n].geneOffset
+            && pRecords[n].neuronOffset <= outputCount && pRecords[n].neuronCount <= outputCount - pRecords[n].neuronOffset;
+    }
+
+    Analytics history;
+    size_t cursor = header.sections[AnalyticsHistory].offset;
+    const size_t end = cursor + sectionSize(AnalyticsHistory);
+    auto read = [&](void* pData, size_t size) {
+        valid = valid && size <= end - cursor;
+        if (valid) {
+            std::memcpy(pData, &buffer[cursor], size);
+            cursor += size;
+        }
+    };
+    auto readVector = [&](auto& values) {
+        using Value = typename std::decay_t<decltype(values)>::value_type;
+        uint64_t count = 0;
+        read(&count, sizeof(count));
+        valid = valid && count <= (end - cursor) / sizeof(Value);
+        values.resize(valid ? count : 0);
+        read(values.data(), values.size() * sizeof(Value));
+    };
+    readVector(history.m_Survivors);
+    readVector(history.m_GeneticDiversity);
+    uint64_t taskRows = 0;
+    read(&taskRows, sizeof(taskRows));
+    for (uint64_t row = 0; valid && row < taskRows; ++row) {
+        history.m_CompletedChallengeTasks.emplace_back();
+        readVector(history.m_CompletedChallengeTasks.back());
+    }
+    uint32_t taskCount = 0;
+    read(&taskCount, sizeof(taskCount));
+    history.m_ChallengeTaskCount = taskCount;
+    readVector(history.m_AvgAge);
+    readVector(history.m_SurvivorsToNextGen);
+    readVector(history.m_StepTimes);
+    readVector(history.m_TurnoverTimes);
+
+    if (!valid) {
+        std::cerr << "Invalid checkpoint " << path << "." << std::endl;
+        return false;
+    }
+
+    m_Sensors.UpdateAvailableSensorTypes(sensorTypes);
+    m_Actions.UpdateAvailableActionTypes(actionTypes);
+
+    // The neural nets are rebuilt from the genomes, the peeps are independent.
+    const auto* pGenes = reinterpret_cast<const Genetics::Gene*>(sectionData(Genes));
+    const auto* pOutputs = reinterpret_cast<const float*>(sectionData(NeuronOutputs));
+    const uint8_t sensorTypeCount = sensorTypes.size();
+    const uint8_t actionTypeCount = actionTypes.size();
+    const int64_t population = header.population;
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(dynamic, 256)
+    for (int64_t n = 0; n < population; ++n) {
+        const PeepRecord& record = pRecords[n];
+        Peep& peep = m_PeepsPool[PeepIndex(n + 1)];
+        peep.index = PeepIndex(n + 1);
+        peep.alive = record.alive;
+        peep.survivedToNextGen = record.survivedToNextGen;
+        peep.plannedLoc = Coord(record.plannedLocX, record.plannedLocY);
+        peep.plannedSimStep = record.plannedSimStep;
+        peep.planTimeUpdateStep = record.planTimeUpdateStep;
+        peep.loc = Coord(record.locX, record.locY);
+        peep.birthLoc = Coord(record.birthLocX, record.birthLocY);
+        peep.age = record.age;
+        peep.responsiveness = record.responsiveness;
+        peep.oscPeriod = record.oscPeriod;
+        peep.longProbeDist = record.longProbeDist;
+        peep.lastMoveDir = Dir(static_cast<Compass>(record.lastMoveDir));
+        peep.challengeBits = record.challengeBits;
+        peep.genome.assign(pGenes + record.geneOffset, pGenes + record.geneOffset + record.geneCount);
+        peep.createWiringFromGenome(sensorTypeCount, actionTypeCount, m_Params);
+        if (peep.nnet.neurons.size() == record.neuronCount) {
+            for (unsigned neuronNum = 0; neuronNum < record.neuronCount; ++neuronNum) {
+                peep.nnet.neurons[neuronNum].output = pOutputs[record.neuronOffset + neuronNum];
+            }
+        }
+    }
+
+    // The barrier objects are only drawn by the UI. Objects of a random layout do
+    // not match the restored cells.
+    const eBarrierType barrierType = static_cast<eBarrierType>(
+        header.generation >= m_Params.replaceBarrierTypeGenerationNumber ? m_Params.replaceBarrierType : m_Params.barrierType);
+    Barriers::createBarrier(barrierType, m_Barriers, m_Random, m_Params);
+    m_PeepsPool.rebuildLivePeeps();
+    const auto* pCenters = reinterpret_cast<const Coord*>(sectionData(BarrierCenters));
+    m_Grid.restoreCells(reinterpret_cast<const PeepIndex*>(sectionData(GridCells)),
+                        std::vector<Coord>(pCenters, pCenters + sectionSize(BarrierCenters) / sizeof(Coord)));
+    for (uint16_t layerNum = 0; layerNum < header.signalLayers; ++layerNum) {
+        m_PheromoneSignals.restoreLayer(layerNum, sectionData(SignalCells) + layerNum * layerSize);
+    }
+
+    m_Analytics = std::move(history);
+    m_GenerationGenerator.SetOldestAge(header.oldestAge);
+    uint64_t nextId;
+    std::memcpy(&nextId, sectionData(LineageIds), sizeof(nextId));
+    std::vector<uint64_t> lineageIds(sectionSize(LineageIds) / sizeof(uint64_t) - 1);
+    std::memcpy(lineageIds.data(), sectionData(LineageIds) + sizeof(nextId), lineageIds.size() * sizeof(uint64_t));
+    m_GenerationGenerator.GetPhylogeny().Resume(nextId, lineageIds);
+    RandomUintGenerator::State randomState;
+    std::memcpy(&randomState, sectionData(RandomState), sizeof(randomState));
+    m_Random.setState(randomState);
+    generation = header.generation;
+
+    std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Restored generation " << generation << " of " << header.population << " peeps from " << path
+              << " in " << duration.count() << " ms." << std::endl;
+    return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Barriers/iBarriers.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Actions;
+class Analytics;
+class GenerationGenerator;
+class Grid;
+class Parameters;
+class PeepsPool;
+class PheromoneSignals;
+class RandomUintGenerator;
+class Sensors;
+
+/*! \class Checkpoint
+    \brief Saves and restores the simulation state between two generations.
+
+    The file is a fixed header with a table of sections, each aligned to cAlignment
+    bytes and stored in native byte order, so every array can be used in place when
+    the file is mapped. The peeps are fixed-size records that point into one array
+    of all genes and one array of all neuron outputs. The neural nets are not stored,
+    Restore() rebuilds them from the genomes in parallel.
+*/
+class Checkpoint
+{
+public:
+    Checkpoint(
+        Grid& grid,
+        PeepsPool& peepsPool,
+        PheromoneSignals& pheromones,
+        Analytics& analytics,
+        Sensors& sensors,
+        Actions& actions,
+        GenerationGenerator& generationGenerator,
+        RandomUintGenerator& random,
+        const Parameters& params,
+        std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers);
+
+    //! Waits for the snapshot processes and commits their checkpoints.
+    ~Checkpoint();
+
+    //! Writes the state before \a generation runs. The file is written next to \a path
+    //! and renamed when complete, a crash never leaves a partial checkpoint behind.
+    //! If Parameters::checkpointSnapshots is set on Linux, the process is forked instead and
+    //! the child writes the file, the sim thread only pauses to lay out the file and to fork.
+    //! The checkpoint is skipped if checkpointSnapshots children are still writing.
+    //! Returns false on errors and skipped checkpoints.
+    bool Save(const std::string& path, unsigned generation, unsigned challenge);
+    //! Reaps the finished snapshot processes and renames their files to the checkpoint path,
+    //! unless a later snapshot is already in place. Waits for all of them if \a wait is set.
+    //! Called once per generation.
+    void PollSnapshots(bool wait = false);
+    //! Restores the state saved by Save() and returns the generation to run next in
+    //! \a generation. Fails without touching the state if the file is missing or was
+    //! saved with another world size, population, signal layer count or PeepIndex width.
+    bool Restore(const std::string& path, unsigned& generation, unsigned challenge);
+
+private:
+    static constexpr unsigned cVersion = 3;
+    static constexpr size_t cAlignment = 64;
+
+    //! A checkpoint being written by a child process.
+    struct Snapshot {
+        int pid;
+        unsigned sequence;
+        unsigned generation;
+        std::string tempPath;
+        std::string path;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    //! Forks a child that writes the checkpoint, see Save().
+    bool SaveSnapshot(const std::string& path, unsigned generation, unsigned challenge);
+    //! Lays out the checkpoint of the current state: builds the header with the section table
+    //! and the small sections up to the peep records into m_Prefix and sizes m_LayerBuffer.
+    void Prepare(unsigned generation, unsigned challenge);
+    //! Writes the checkpoint laid out by Prepare() with open, write, fsync and close only.
+    //! It neither allocates nor prints, so the forked child of SaveSnapshot() may call it.
+    bool WriteFile(const std::string& filePath);
+    //! Replaces the checkpoint at \a path by the complete file at \a tempPath.
+    static bool Commit(const std::string& tempPath, const std::string& path);
+
+    Grid&                                               m_Grid;
+    PeepsPool&                                          m_PeepsPool;
+    PheromoneSignals&                                   m_PheromoneSignals;
+    Analytics&                                          m_Analytics;
+    Sensors&                                            m_Sensors;
+    Actions&                                            m_Actions;
+    GenerationGenerator&                                m_GenerationGenerator;
+    RandomUintGenerator&                                m_Random;
+    const Parameters&                                   m_Params;
+    std::vector<std::unique_ptr<Barriers::iBarrier> >&  m_Barriers;
+    std::vector<Snapshot>                               m_Snapshots{};          ///< Running snapshot processes, oldest first.
+    unsigned                                            m_Sequence{};           ///< Count of the started checkpoints.
+    unsigned                                            m_CommittedSequence{};  ///< Sequence number of the checkpoint in place.
+    std::vector<uint8_t>                                m_Prefix{};             ///< The start of the file, see Prepare().
+    std::vector<uint8_t>                                m_LayerBuffer{};        ///< One layer of grid or signal cells.
+};
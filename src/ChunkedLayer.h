@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*! \class ChunkedLayer
+    \brief Sparse 2D container of cChunkSize x cChunkSize chunks.
+
+    A chunk is allocated on the first write of a non-zero value and freed by
+    ReleaseEmptyChunks() once all of its cells are back to zero, so the memory is
+    proportional to the non-zero area instead of the world area. Unallocated cells
+    read as zero. Passes over the whole layer iterate the resident chunks only.
+
+    Set() has to be called in single-thread mode or in a critical section, Get() may
+    run in other threads meanwhile. The chunk table holds atomic pointers: a new chunk
+    is published with release once its cells are zeroed and read with acquire, so a
+    reader sees either no chunk or a complete one. The chunks are owned by m_Resident.
+*/
+template <typename T>
+class ChunkedLayer
+{
+public:
+    static constexpr unsigned cChunkBits = 6;
+    static constexpr unsigned cChunkSize = 1u << cChunkBits;
+    static constexpr unsigned cChunkMask = cChunkSize - 1;
+
+    //! Cells of a chunk, column major like the dense containers.
+    struct Chunk {
+        std::array<T, cChunkSize * cChunkSize> cells{};
+        unsigned nonZeroCount{};  ///< The chunk can be released when it drops to 0.
+    };
+
+    //! Sets the dimensions, frees all chunks.
+    void Init(uint16_t sizeX, uint16_t sizeY)
+    {
+        m_ChunksX = (sizeX + cChunkMask) >> cChunkBits;
+        m_ChunksY = (sizeY + cChunkMask) >> cChunkBits;
+        // The atomics can't be moved, the table is replaced as a whole.
+        m_Chunks = std::vector<std::atomic<Chunk*>>(m_ChunksX * m_ChunksY);
+        m_Resident.clear();
+    }
+
+    T Get(uint16_t x, uint16_t y) const
+    {
+        const Chunk* pChunk = m_Chunks[ChunkIndex(x, y)].load(std::memory_order_acquire);
+        return pChunk ? pChunk->cells[CellIndex(x, y)] : T{};
+    }
+
+    void Set(uint16_t x, uint16_t y, T val)
+    {
+        // The writers are serialized, only the readers need the acquire.
+        std::atomic<Chunk*>& slot = m_Chunks[ChunkIndex(x, y)];
+        Chunk* pChunk = slot.load(std::memory_order_relaxed);
+        if (!pChunk) {
+            if (val == T{}) {
+                return;
+            }
+            auto chunk = std::make_unique<Chunk>();
+            pChunk = chunk.get();
+            m_Resident.push_back({ChunkIndex(x, y), std::move(chunk)});
+            slot.store(pChunk, std::memory_order_release);
+        }
+        T& cell = pChunk->cells[CellIndex(x, y)];
+        pChunk->nonZeroCount += (val != T{}) - (cell != T{});
+        cell = val;
+    }
+
+    //! Calls f(chunk, originX, originY) for every resident chunk. The callback may
+    //! modify the cells but has to keep Chunk::nonZeroCount up to date.
+    template <typename F>
+    void ForEachResidentChunk(F&& f)
+    {
+        for (Resident& resident : m_Resident) {
+            f(*resident.chunk,
+              uint16_t((resident.chunkIndex / m_ChunksY) << cChunkBits),
+              uint16_t((resident.chunkIndex % m_ChunksY) << cChunkBits));
+        }
+    }
+
+    template <typename F>
+    void ForEachResidentChunk(F&& f) const
+    {
+        for (const Resident& resident : m_Resident) {
+            f(static_cast<const Chunk&>(*resident.chunk),
+              uint16_t((resident.chunkIndex / m_ChunksY) << cChunkBits),
+              uint16_t((resident.chunkIndex % m_ChunksY) << cChunkBits));
+        }
+    }
+
+    //! Frees the chunks that only hold zeros.
+    void ReleaseEmptyChunks()
+    {
+        for (size_t slot = 0; slot < m_Resident.size();) {
+            Resident& resident = m_Resident[slot];
+            if (resident.chunk->nonZeroCount > 0) {
+                ++slot;
+                continue;
+            }
+            m_Chunks[resident.chunkIndex].store(nullptr, std::memory_order_relaxed);
+            resident = std::move(m_Resident.back());
+            m_Resident.pop_back();
+        }
+    }
+
+    //! Frees all chunks.
+    void Clear()
+    {
+        for (const Resident& resident : m_Resident) {
+            m_Chunks[resident.chunkIndex].store(nullptr, std::memory_order_relaxed);
+        }
+        m_Resident.clear();
+    }
+
+    size_t ResidentChunkCount() const { return m_Resident.size(); }
+
+    static unsigned CellIndex(uint16_t x, uint16_t y) { return ((x & cChunkMask) << cChunkBits) | (y & cChunkMask); }
+
+private:
+    //! An allocated chunk and its index in the chunk table.
+    struct Resident {
+        uint32_t chunkIndex;
+        std::unique_ptr<Chunk> chunk;
+    };
+
+    uint32_t ChunkIndex(uint16_t x, uint16_t y) const { return (x >> cChunkBits) * m_ChunksY + (y >> cChunkBits); }
+
+    unsigned m_ChunksX{};
+    unsigned m_ChunksY{};
+    std::vector<std::atomic<Chunk*>> m_Chunks{};    ///< Chunk table, nullptr where all cells are zero.
+    std::vector<Resident> m_Resident{};             ///< The allocated chunks.
+};
@@ -0,0 +1,299 @@
+#include "FrameRecorder.h"
+
+#include "Genome.h"
+#include "Grid.h"
+#include "Parameters.h"
+#include "PeepsPool.h"
+#include "PheromoneSignals.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+
+//-------------------------------------------------------------------------
+QColor ConvertUint8ToQColor(uint8_t c)
+{
+    constexpr uint8_t maxColorVal = 0xb0;
+    constexpr uint8_t maxLumaVal = 0xb0;
+    auto rgbToLuma = [](uint8_t r, uint8_t g, uint8_t b) { return (r + r + r + b + g + g + g + g) / 8; };
+
+    uint8_t r = (c);                  // R: 0..255
+    uint8_t g = ((c & 0x1f) << 3);    // G: 0..255
+    uint8_t b = ((c & 7)    << 5);    // B: 0..255
+
+    // Prevent color mappings to very bright colors (hard to see):
+    if (rgbToLuma(r, g, b) > maxLumaVal) {
+        if (r > maxColorVal) r %= maxColorVal;
+        if (g > maxColorVal) g %= maxColorVal;
+        if (b > maxColorVal) b %= maxColorVal;
+    }
+    return QColor(r, g, b);
+}
+
+//-------------------------------------------------------------------------
+FrameRecorder::FrameRecorder(const Parameters& params)
+    : m_Params(params)
+{
+    for (unsigned index = 0; index < cFrameBuffers; ++index) {
+        m_FreeFrames.push_back(std::make_unique<Frame>());
+    }
+    m_Writer = std::thread(&FrameRecorder::WriterLoop, this);
+}
+
+//-------------------------------------------------------------------------
+FrameRecorder::~FrameRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wakeup.notify_one();
+    m_Writer.join();
+}
+
+//-------------------------------------------------------------------------
+bool FrameRecorder::IsRecording(unsigned generation) const
+{
+    return m_Params.saveVideo
+        && (generation % m_Params.videoStride == 0 || generation <= m_Params.videoSaveFirstFrames);
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::AddFrame(unsigned simStep, unsigned generation, const Grid& grid, const PeepsPool& peeps, const PheromoneSignals& pheromoneSignals)
+{
+    std::unique_ptr<Frame> pFrame;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_FreeFrames.empty()) {
+            pFrame = std::move(m_FreeFrames.back());
+            m_FreeFrames.pop_back();
+        }
+    }
+    if (!pFrame) {
+        ++m_DroppedFrames;
+        return;
+    }
+
+    // The barriers do not move within a generation.
+    if (!m_Barriers) {
+        auto pBarriers = std::make_shared<std::vector<Coord>>();
+        for (int16_t x = 0; x < m_Params.sizeX; ++x) {
+            for (int16_t y = 0; y < m_Params.sizeY; ++y) {
+                if (grid.isBarrierAt(Coord(x, y))) {
+                    pBarriers->push_back(Coord(x, y));
+                }
+            }
+        }
+        m_Barriers = std::move(pBarriers);
+    }
+
+    pFrame->simStep = simStep;
+    pFrame->generation = generation;
+    pFrame->sizeX = m_Params.sizeX;
+    pFrame->sizeY = m_Params.sizeY;
+    pFrame->barriers = m_Barriers;
+    pFrame->peeps.clear();
+    for (PeepIndex index : peeps.livePeeps()) {
+        const Peep& peep = peeps[index];
+        pFrame->peeps.push_back({peep.loc.x, peep.loc.y, Genetics::makeGeneticColor(peep.genome)});
+    }
+    const size_t layerSize = size_t(pFrame->sizeX) * pFrame->sizeY;
+    pFrame->signalLayers = pheromoneSignals.layerCount();
+    pFrame->signalCells.resize(pFrame->signalLayers * layerSize);
+    for (uint16_t layerNum = 0; layerNum < pFrame->signalLayers; ++layerNum) {
+        pheromoneSignals.copyLayer(layerNum, &pFrame->signalCells[layerNum * layerSize]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back({std::move(pFrame), generation});
+    }
+    m_Wakeup.notify_one();
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::EndGeneration(unsigned generation)
+{
+    m_Barriers.reset();
+    if (!IsRecording(generation)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back({nullptr, generation});
+    }
+    m_Wakeup.notify_one();
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_Wakeup.wait(lock, [this]() { return m_Stop || !m_Queue.empty(); });
+        if (m_Queue.empty()) {
+            break;
+        }
+        Job job = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        lock.unlock();
+
+        if (job.frame) {
+            Write(*job.frame);
+        } else if (m_MovieOpen && m_MovieGeneration == job.generation) {
+            CloseMovie();
+        }
+
+        lock.lock();
+        if (job.frame) {
+            m_FreeFrames.push_back(std::move(job.frame));
+        }
+    }
+    lock.unlock();
+    CloseMovie();
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::Write(const Frame& frame)
+{
+    const bool raw = m_Params.videoFormat == "raw";
+    if (m_MovieOpen && m_MovieGeneration != frame.generation) {
+        CloseMovie();
+    }
+    if (!m_MovieOpen) {
+        char name[32];
+        std::snprintf(name, sizeof(name), raw ? "gen-%06u.raw" : "gen-%06u", frame.generation);
+        m_MoviePath = m_Params.imageDir + "/" + name;
+        std::error_code error;
+        std::filesystem::create_directories(raw ? m_Params.imageDir : m_MoviePath, error);
+        if (raw) {
+            m_RawFile.open(m_MoviePath, std::ios::binary | std::ios::trunc);
+            if (!m_RawFile) {
+                std::cerr << "Couldn't open movie file " << m_MoviePath << "." << std::endl;
+            }
+            WriteRawHeader(frame);
+        }
+        m_MovieOpen = true;
+        m_MovieGeneration = frame.generation;
+        m_MovieFrames = 0;
+    }
+
+    if (raw) {
+        WriteRawFrame(frame);
+    } else {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame-%06u.png", frame.simStep);
+        Rasterize(frame);
+        if (!m_Image.save(QString::fromStdString(m_MoviePath + name), "PNG")) {
+            std::cerr << "Couldn't save movie frame " << m_MoviePath << name << "." << std::endl;
+        }
+    }
+    ++m_MovieFrames;
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::Rasterize(const Frame& frame)
+{
+    static const QColor signalTints[] = {QColor(0x30, 0x60, 0xc0), QColor(0xc0, 0x30, 0x60), QColor(0x30, 0xa0, 0x40), QColor(0xc0, 0x90, 0x20)};
+    const QColor barrierColor(Qt::darkGray);
+    const int scale = std::max(1u, m_Params.displayScale);
+    if (m_Image.width() != frame.sizeX * scale || m_Image.height() != frame.sizeY * scale) {
+        m_Image = QImage(frame.sizeX * scale, frame.sizeY * scale, QImage::Format_RGB888);
+    }
+    m_Image.fill(Qt::white);
+
+    auto fillCell = [this, &frame, scale](int x, int y, const QColor& color) {
+        for (int row = (frame.sizeY - 1 - y) * scale; row < (frame.sizeY - y) * scale; ++row) {
+            uchar* pPixel = m_Image.scanLine(row) + x * scale * 3;
+            for (int column = 0; column < scale; ++column, pPixel += 3) {
+                pPixel[0] = color.red();
+                pPixel[1] = color.green();
+                pPixel[2] = color.blue();
+            }
+        }
+    };
+
+    // Each layer is blended over white with its magnitude as opacity.
+    const size_t layerSize = size_t(frame.sizeX) * frame.sizeY;
+    for (int x = 0; x < frame.sizeX; ++x) {
+        for (int y = 0; y < frame.sizeY; ++y) {
+            int red = 255, green = 255, blue = 255;
+            for (unsigned layerNum = 0; layerNum < frame.signalLayers; ++layerNum) {
+                const int magnitude = frame.signalCells[layerNum * layerSize + size_t(x) * frame.sizeY + y];
+                const QColor& tint = signalTints[layerNum % std::size(signalTints)];
+                red += (tint.red() - red) * magnitude / 255;
+                green += (tint.green() - green) * magnitude / 255;
+                blue += (tint.blue() - blue) * magnitude / 255;
+            }
+            if (red != 255 || green != 255 || blue != 255) {
+                fillCell(x, y, QColor(red, green, blue));
+            }
+        }
+    }
+    for (const Coord& loc : *frame.barriers) {
+        fillCell(loc.x, loc.y, barrierColor);
+    }
+
+    QPainter painter(&m_Image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    const qreal radius = std::max(1u, m_Params.agentSize) / 2.0;
+    for (const PeepRecord& peep : frame.peeps) {
+        painter.setBrush(ConvertUint8ToQColor(peep.color));
+        painter.drawEllipse(QPointF((peep.x + 0.5) * scale, (frame.sizeY - peep.y - 0.5) * scale), radius, radius);
+    }
+}
+
+// Raw container layout, native byte order:
+//   header: "GOEVRAW1", uint16 sizeX, uint16 sizeY, uint32 signal layers,
+//           uint32 barrier count, barrier count * (int16 x, int16 y)
+//   frames: uint32 simStep, uint32 peep count, peep count * (int16 x, int16 y, uint8 color),
+//           signal layers * sizeX * sizeY magnitudes, x major
+//-------------------------------------------------------------------------
+void FrameRecorder::WriteRawHeader(const Frame& frame)
+{
+    const uint32_t signalLayers = frame.signalLayers;
+    const uint32_t barrierCount = frame.barriers->size();
+    m_RawFile.write("GOEVRAW1", 8);
+    m_RawFile.write(reinterpret_cast<const char*>(&frame.sizeX), sizeof(frame.sizeX));
+    m_RawFile.write(reinterpret_cast<const char*>(&frame.sizeY), sizeof(frame.sizeY));
+    m_RawFile.write(reinterpret_cast<const char*>(&signalLayers), sizeof(signalLayers));
+    m_RawFile.write(reinterpret_cast<const char*>(&barrierCount), sizeof(barrierCount));
+    for (const Coord& loc : *frame.barriers) {
+        m_RawFile.write(reinterpret_cast<const char*>(&loc.x), sizeof(loc.x));
+        m_RawFile.write(reinterpret_cast<const char*>(&loc.y), sizeof(loc.y));
+    }
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::WriteRawFrame(const Frame& frame)
+{
+    const uint32_t simStep = frame.simStep;
+    const uint32_t peepCount = frame.peeps.size();
+    m_RawFile.write(reinterpret_cast<const char*>(&simStep), sizeof(simStep));
+    m_RawFile.write(reinterpret_cast<const char*>(&peepCount), sizeof(peepCount));
+    for (const PeepRecord& peep : frame.peeps) {
+        m_RawFile.write(reinterpret_cast<const char*>(&peep.x), sizeof(peep.x));
+        m_RawFile.write(reinterpret_cast<const char*>(&peep.y), sizeof(peep.y));
+        m_RawFile.write(reinterpret_cast<const char*>(&peep.color), sizeof(peep.color));
+    }
+    m_RawFile.write(reinterpret_cast<const char*>(frame.signalCells.data()), frame.signalCells.size());
+}
+
+//-------------------------------------------------------------------------
+void FrameRecorder::CloseMovie()
+{
+    if (!m_MovieOpen) {
+        return;
+    }
+    if (m_RawFile.is_open()) {
+        m_RawFile.close();
+    }
+    m_MovieOpen = false;
+    std::cout << "Saved " << m_MovieFrames << " frames of generation " << m_MovieGeneration
+              << " to " << m_MoviePath << ", " << m_DroppedFrames << " frames dropped so far." << std::endl;
+}
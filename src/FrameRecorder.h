@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <QColor>
+#include <QImage>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Grid;
+class PeepsPool;
+class Parameters;
+class PheromoneSignals;
+
+//! Converts the genetic color of a peep to the color it is drawn with.
+QColor ConvertUint8ToQColor(uint8_t c);
+
+/*! \class FrameRecorder
+    \brief Records the generation movies in the background.
+
+    The sim thread copies the peeps and the signal layers of a sim step into one of
+    cFrameBuffers reusable frames and queues it. A writer thread turns the queued frames
+    into the movie of the generation in Parameters::imageDir, see Parameters::videoFormat.
+    If the writer lags and no frame is free, the sim step is dropped from the movie.
+*/
+class FrameRecorder
+{
+public:
+    FrameRecorder(const Parameters& params);
+    //! Writes the queued frames, then stops the writer thread.
+    ~FrameRecorder();
+
+    //! Returns true if the movie of the generation is recorded, see Parameters::saveVideo.
+    bool IsRecording(unsigned generation) const;
+    //! Queues the world at the end of a sim step, or drops it if no frame is free.
+    //! Called in single-thread mode.
+    void AddFrame(unsigned simStep, unsigned generation, const Grid& grid, const PeepsPool& peeps, const PheromoneSignals& pheromoneSignals);
+    //! Closes the movie of the generation after its queued frames are written.
+    void EndGeneration(unsigned generation);
+    //! Returns the count of the dropped frames.
+    unsigned DroppedFrames() const { return m_DroppedFrames; }
+
+private:
+    static constexpr unsigned cFrameBuffers = 8;
+
+    //! A peep as recorded, its location and its genetic color.
+    struct PeepRecord {
+        int16_t x;
+        int16_t y;
+        uint8_t color;
+    };
+    //! The copy of one sim step.
+    struct Frame {
+        unsigned simStep{};
+        unsigned generation{};
+        uint16_t sizeX{};
+        uint16_t sizeY{};
+        unsigned signalLayers{};
+        std::vector<PeepRecord> peeps{};
+        std::vector<uint8_t> signalCells{};                     ///< All layers, see PheromoneSignals::copyLayer().
+        std::shared_ptr<const std::vector<Coord>> barriers{};   ///< Shared by all frames of a generation.
+    };
+    //! A frame to write, or the end of a generation if frame is empty.
+    struct Job {
+        std::unique_ptr<Frame> frame{};
+        unsigned generation{};
+    };
+
+    //! Runs in the writer thread until m_Stop is set and the queue is empty.
+    void WriterLoop();
+    //! Opens the movie of the frame's generation if needed and appends the frame.
+    void Write(const Frame& frame);
+    //! Draws the frame to m_Image, y pointing up like in the UI.
+    void Rasterize(const Frame& frame);
+    //! Writes the header of a raw container.
+    void WriteRawHeader(const Frame& frame);
+    //! Writes the frame to the raw container.
+    void WriteRawFrame(const Frame& frame);
+    void CloseMovie();
+
+    const Parameters&                           m_Params;
+    std::mutex                                  m_Mutex{};
+    std::condition_variable                     m_Wakeup{};
+    std::vector<std::unique_ptr<Frame>>         m_FreeFrames{};         ///< Frames ready to be filled by the sim thread.
+    std::deque<Job>                             m_Queue{};              ///< Jobs for the writer thread.
+    bool                                        m_Stop{false};
+    std::atomic<unsigned>                       m_DroppedFrames{0};
+
+    // Sim thread only.
+    std::shared_ptr<const std::vector<Coord>>   m_Barriers{};           ///< Barrier cells of the recorded generation,
+                                                                        ///< collected by its first frame.
+
+    // Writer thread only.
+    bool                                        m_MovieOpen{false};
+    unsigned                                    m_MovieGeneration{};
+    unsigned                                    m_MovieFrames{};        ///< Frames written to the open movie.
+    std::string                                 m_MoviePath{};          ///< Directory of the PNG sequence or the raw container.
+    std::ofstream                               m_RawFile{};
+    QImage                                      m_Image{};              ///< Reused for every PNG frame.
+
+    std::thread                                 m_Writer{};             ///< Started last, stopped first.
+};
@@ -4,6 +4,7 @@
 #include "Analytics.h"
 #include "Barriers/iBarriers.h"
 #include "Challenges/iChallenges.h"
+#include "GenomeBank.h"
 #include "Grid.h"
 #include "Parameters.h"
 #include "PeepsPool.h"
@@ -12,6 +13,8 @@
 #include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <iostream>
+#include <sstream>
 
 
 //-------------------------------------------------------------------------
@@ -23,6 +26,7 @@ GenerationGenerator::GenerationGenerator(
     const Parameters& params,
     RandomUintGenerator& random,
     const eBarrierType& barrierType,
+    const eChallenges& challenge,
     std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers)
     : m_Grid(grid)
     , m_PeepsPool(peepsPool)
@@ -31,11 +35,40 @@ GenerationGenerator::GenerationGenerator(
     , m_Params(params)
     , m_Random(random)
     , m_BarrierType(barrierType)
+    , m_Challenge(challenge)
     , m_Barriers(barriers)
+    , m_ParentSelection(params)
+    , m_xPhylogeny(std::make_unique<PhylogenyRecorder>(params))
 {
     
 }
 
+//-------------------------------------------------------------------------
+void GenerationGenerator::LoadGenomeBanks()
+{
+    m_BankGenomes.clear();
+    m_GenomeBanks.clear();
+    std::istringstream paths(m_Params.genomeBankImport);
+    std::string path;
+    while (std::getline(paths, path, ',')) {
+        GenomeBank bank;
+        if (!path.empty() && bank.Open(path)) {
+            std::cout << "Genome bank " << path << ": " << bank.Size() << " genomes" << std::endl;
+            m_GenomeBanks.push_back(std::move(bank));
+        }
+    }
+    // The banks are not moved anymore, the pointers stay valid.
+    for (const GenomeBank& bank : m_GenomeBanks) {
+        for (size_t n = 0; n < bank.Size(); ++n) {
+            m_BankGenomes.emplace_back(&bank, n);
+        }
+    }
+    std::stable_sort(m_BankGenomes.begin(), m_BankGenomes.end(),
+        [](const std::pair<const GenomeBank*, size_t>& genome1, const std::pair<const GenomeBank*, size_t>& genome2) {
+            return genome1.first->GetEntry(genome1.second).fitness > genome2.first->GetEntry(genome2.second).fitness;
+        });
+}
+
 //-------------------------------------------------------------------------
 void GenerationGenerator::initializeGeneration0(
     eBarrierType barrierType,
@@ -52,123 +85,173 @@ void GenerationGenerator::initializeGeneration0(
     m_PheromoneSignals.zeroFill();
 
     // Spawn the population. The peeps container has already been allocated,
-    // just clear and reuse it
-    for (uint16_t index = 1; index <= m_Params.population; ++index) {
-        m_PeepsPool[index].initialize(index, m_Grid.findEmptyLocation(), makeRandomGenome(), m_Random, sensorTypeCount, actionTypeCount, m_Grid);
+    // just clear and reuse it. The genomes and nets are built in parallel, each peep
+    // draws from its own generator so that the result doesn't depend on the thread count.
+    const uint32_t seed = m_Random();
+    const int64_t population = m_Params.population;
+    m_xPhylogeny->BeginSpawn(0, {});
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(dynamic, 64)
+    for (int64_t n = 0; n < population; ++n) {
+        const PeepIndex index = PeepIndex(n + 1);
+        RandomUintGenerator random(seed, index);
+        Genetics::Genome genome = m_BankGenomes.empty() ? makeRandomGenome(random) : makeBankGenome(index - 1, random);
+        m_xPhylogeny->AddBirth(index, Phylogeny::cNoParent, Phylogeny::cNoParent, genome, nullptr);
+        m_PeepsPool[index].initialize(index, std::move(genome), sensorTypeCount, actionTypeCount, m_Params);
     }
+    m_xPhylogeny->EndSpawn();
+    placePeeps();
     m_OldestAge = 0;
 }
 
 //-------------------------------------------------------------------------
-Genetics::Genome GenerationGenerator::makeRandomGenome()
+Genetics::Genome GenerationGenerator::makeRandomGenome(RandomUintGenerator& random) const
 {
     Genetics::Genome genome;
 
-    unsigned length = m_Random(m_Params.genomeInitialLengthMin, m_Params.genomeInitialLengthMax);
+    unsigned length = random(m_Params.genomeInitialLengthMin, m_Params.genomeInitialLengthMax);
+    genome.reserve(length);
     for (unsigned n = 0; n < length; ++n) {
-        genome.push_back(Genetics::makeRandomGene(m_Random));
+        genome.push_back(Genetics::makeRandomGene(random));
     }
 
     return genome;
 }
 
 //-------------------------------------------------------------------------
-Genetics::Genome GenerationGenerator::generateChildGenome(const std::vector<Genetics::Genome> &parentGenomes)
+Genetics::Genome GenerationGenerator::makeBankGenome(unsigned n, RandomUintGenerator& random) const
 {
-    // random parent (or parents if sexual reproduction) with random
-    // mutations
-    Genetics::Genome genome;
+    const auto& [pBank, entry] = m_BankGenomes[n % m_BankGenomes.size()];
+    const Genetics::Gene* pGenes = pBank->GetGenes(entry);
+    Genetics::Genome genome(pGenes, pGenes + pBank->GetEntry(entry).geneCount);
 
-    uint16_t parent1Idx;
-    uint16_t parent2Idx;
+    if (genome.size() > m_Params.genomeMaxLength) {
+        Genetics::cropLength(genome, m_Params.genomeMaxLength, random);
+    }
+    if (n >= m_BankGenomes.size()) {
+        applyPointMutations(genome, random, m_Params);
+    }
+
+    return genome;
+}
 
-    // Choose two parents randomly from the candidates. If the parameter
+//-------------------------------------------------------------------------
+void GenerationGenerator::generateChildGenome(
+    const std::vector<const Genetics::Genome*> &parentGenomes,
+    Genetics::Genome& genome,
+    unsigned& primaryParent,
+    unsigned& secondaryParent,
+    RandomUintGenerator& random) const
+{
+    // random parent (or parents if sexual reproduction) with random
+    // mutations. The parent's genes are assigned to the genome, which
+    // reuses its buffer.
+    unsigned parent1Idx;
+    unsigned parent2Idx;
+
+    // Choose two parents from the candidates. If the parameter
     // p.chooseParentsByFitness is false, then we choose at random from
     // all the candidate parents with equal preference. If the parameter is
     // true, then we give preference to candidate parents according to their
-    // score. Their score was computed by the survival/selection algorithm
-    // in survival-criteria.cpp.
-    if (m_Params.chooseParentsByFitness && parentGenomes.size() > 1) {
-        parent1Idx = m_Random(1, parentGenomes.size() - 1);
-        parent2Idx = m_Random(0, parent1Idx - 1);
-    } else {
-        parent1Idx = m_Random(0, parentGenomes.size() - 1);
-        parent2Idx = m_Random(0, parentGenomes.size() - 1);
-    }
+    // score and p.parentSelectionMethod. Their score was computed by the
+    // survival/selection algorithm in survival-criteria.cpp.
+    m_ParentSelection.Draw(parent1Idx, parent2Idx, random);
 
-    const Genetics::Genome &g1 = parentGenomes[parent1Idx];
-    const Genetics::Genome &g2 = parentGenomes[parent2Idx];
+    const Genetics::Genome &g1 = *parentGenomes[parent1Idx];
+    const Genetics::Genome &g2 = *parentGenomes[parent2Idx];
 
     if (g1.empty() || g2.empty()) {
         assert(false);
     }
 
-    auto overlayWithSliceOf = [&](const Genetics::Genome &gShorter) {
-        uint16_t index0 = m_Random(0, gShorter.size() - 1);
-        uint16_t index1 = m_Random(0, gShorter.size());
-        if (index0 > index1) {
-            std::swap(index0, index1);
-        }
-        std::copy(&gShorter[index0], &gShorter[index1], &genome[index0]);
-    };
-
     if (m_Params.sexualReproduction) {
         if (g1.size() > g2.size()) {
-            genome = g1;
-            overlayWithSliceOf(g2);
-            assert(!genome.empty());
+            Genetics::crossOver(genome, g1, g2, random);
+            primaryParent = parent1Idx;
+            secondaryParent = parent2Idx;
         } else {
-            genome = g2;
-            overlayWithSliceOf(g1);
-            assert(!genome.empty());
-        }
-
-        // Trim to length = average length of parents
-        unsigned sum = g1.size() + g2.size();
-        // If average length is not an integral number, add one half the time
-        if ((sum & 1) && (m_Random() & 1)) {
-            ++sum;
+            Genetics::crossOver(genome, g2, g1, random);
+            primaryParent = parent2Idx;
+            secondaryParent = parent1Idx;
         }
-        Genetics::cropLength(genome, sum / 2, m_Random);
         assert(!genome.empty());
     } else {
         genome = g2;
+        primaryParent = parent2Idx;
+        secondaryParent = Phylogeny::cNoParent;
         assert(!genome.empty());
     }
 
-    Genetics::randomInsertDeletion(genome, m_Random, m_Params);
+    Genetics::randomInsertDeletion(genome, random, m_Params);
     assert(!genome.empty());
-    applyPointMutations(genome, m_Random, m_Params);
+    applyPointMutations(genome, random, m_Params);
     assert(!genome.empty());
     assert(genome.size() <= m_Params.genomeMaxLength);
-
-    return genome;
 }
 
 //-------------------------------------------------------------------------
 void GenerationGenerator::initializeNewGeneration(
-    const std::vector<Genetics::Genome> &parentGenomes,
+    const std::vector<const Genetics::Genome*> &parentGenomes,
     eBarrierType barrierType,
     unsigned generation,
     uint8_t sensorTypeCount,
     uint8_t actionTypeCount)
 {
     // The grid, signals, and peeps containers have already been allocated, just
-    // clear them if needed and reuse the elements
-    m_Grid.zeroFill();
-    m_Grid.createBarrier(generation >= m_Params.replaceBarrierTypeGenerationNumber
+    // clear them if needed and reuse the elements. The dead peeps have left the grid
+    // already, so only the cells of the living ones have to be cleared.
+    for (PeepIndex index : m_PeepsPool.livePeeps()) {
+        m_Grid.set(m_PeepsPool[index].loc, 0);
+    }
+    m_Grid.resetBarrier(generation >= m_Params.replaceBarrierTypeGenerationNumber
                        ? static_cast<eBarrierType>(m_Params.replaceBarrierType) : 
                        static_cast<eBarrierType>(barrierType),
                        m_Barriers);
     m_PheromoneSignals.zeroFill();
 
-    // Spawn the population. This overwrites all the elements of peeps[]
-    for (uint16_t index = 1; index <= m_Params.population; ++index) {
-        if (m_PeepsPool[index].survivedToNextGen)
-            m_PeepsPool[index].relocate(m_Grid.findEmptyLocation(), m_Random, m_Grid);
-        else
-            m_PeepsPool[index].initialize(index, m_Grid.findEmptyLocation(), generateChildGenome(parentGenomes), m_Random, sensorTypeCount, actionTypeCount, m_Grid);
+    // Spawn the population. This overwrites all the elements of peeps[] except the
+    // survivors. The children are written to the spare side in parallel while the
+    // parents are read in place, then they are swapped in and their nets are built.
+    // Each child draws from its own generator, the result doesn't depend on the
+    // thread count.
+    const uint32_t seed = m_Random();
+    const int64_t population = m_Params.population;
+#pragma omp parallel num_threads(m_Params.numThreads)
+    {
+#pragma omp for schedule(dynamic, 64)
+        for (int64_t n = 0; n < population; ++n) {
+            const PeepIndex index = PeepIndex(n + 1);
+            if (m_PeepsPool[index].survivedToNextGen) {
+                continue;
+            }
+            RandomUintGenerator random(seed, index);
+            unsigned primaryParent;
+            unsigned secondaryParent;
+            generateChildGenome(parentGenomes, m_SpareGenomes[index], primaryParent, secondaryParent, random);
+            m_xPhylogeny->AddBirth(index, primaryParent, secondaryParent, m_SpareGenomes[index], parentGenomes[primaryParent]);
+        }
+        // The implicit barrier ends the reads of the parents.
+#pragma omp for schedule(dynamic, 64)
+        for (int64_t n = 0; n < population; ++n) {
+            const PeepIndex index = PeepIndex(n + 1);
+            Peep& peep = m_PeepsPool[index];
+            if (peep.survivedToNextGen) {
+                continue;
+            }
+            Genetics::Genome genome = std::move(m_SpareGenomes[index]);
+            m_SpareGenomes[index] = std::move(peep.genome);
+            peep.initialize(index, std::move(genome), sensorTypeCount, actionTypeCount, m_Params);
+        }
     }
+    placePeeps();
+}
+
+//-------------------------------------------------------------------------
+void GenerationGenerator::placePeeps()
+{
+    for (PeepIndex index = 1; index <= m_Params.population; ++index) {
+        m_PeepsPool[index].relocate(m_Grid.findEmptyLocation(), m_Random, m_Grid, m_Params);
+    }
+    m_PeepsPool.rebuildLivePeeps();
 }
 
 //-------------------------------------------------------------------------
@@ -182,11 +265,11 @@ unsigned GenerationGenerator::spawnNewGeneration(
     auto settings = Challenges::Settings();
     settings.generation = generation;
     settings.murderCount = murderCount;
-    // This container will hold the genomes of the survivors
-    std::vector<Genetics::Genome> parentGenomes;
+    // This container will point to the genomes of the survivors
+    std::vector<const Genetics::Genome*>& parentGenomes = m_ParentGenomes;
     // This container will hold the indexes and survival scores (0.0..1.0)
     // of all the survivors who will provide genomes for repopulation.
-    std::vector<std::pair<uint16_t, float>> parents = pChallenge->EvaluateWhenNewGeneration(
+    std::vector<std::pair<PeepIndex, float>> parents = pChallenge->EvaluateWhenNewGeneration(
         m_PeepsPool,
         m_Params,
         m_Grid,
@@ -194,23 +277,30 @@ unsigned GenerationGenerator::spawnNewGeneration(
 
     // Sort the indexes of the parents by their fitness scores
     std::sort(parents.begin(), parents.end(),
-        [](const std::pair<uint16_t, float> &parent1, const std::pair<uint16_t, float> &parent2) {
+        [](const std::pair<PeepIndex, float> &parent1, const std::pair<PeepIndex, float> &parent2) {
             return parent1.second > parent2.second;
         });
+    m_ParentSelection.Prepare(parents);
+
+    if (m_Params.genomeBankExportCount > 0 && generation % m_Params.genomeBankExportStride == 0) {
+        exportGenomeBank(generation, parents);
+    }
 
     unsigned ageAccumulator = 0;
     unsigned survivorsToNextGenCount = 0;
     // Assemble a list of all the parent genomes. These will be ordered by their
     // scores if the parents[] container was sorted by score.
-    parentGenomes.reserve(parents.size());
-    for (const std::pair<uint16_t, float> &parent : parents) {
+    parentGenomes.resize(parents.size());
+    m_SpareGenomes.resize(m_Params.population + 1);
+    for (size_t n = 0; n < parents.size(); ++n) {
+        const std::pair<PeepIndex, float> &parent = parents[n];
         ageAccumulator += m_PeepsPool[parent.first].age;
         if (m_OldestAge < m_PeepsPool[parent.first].age)
             m_OldestAge = m_PeepsPool[parent.first].age;
         m_PeepsPool[parent.first].survivedToNextGen = m_PeepsPool[parent.first].alive && AlgorithmHelpers::prob2bool(parent.second / 1.5, m_Random);
         if (m_PeepsPool[parent.first].survivedToNextGen)
             survivorsToNextGenCount++;
-        parentGenomes.push_back(m_PeepsPool[parent.first].genome);
+        parentGenomes[n] = &m_PeepsPool[parent.first].genome;
     }
 
     m_Analytics.AddAvgAge(parents.size() > 0 ? ageAccumulator / parents.size() : 0.0);
@@ -225,7 +315,9 @@ unsigned GenerationGenerator::spawnNewGeneration(
 
     if (!parentGenomes.empty()) {
         // Spawn a new generation
+        m_xPhylogeny->BeginSpawn(generation + 1, parents);
         initializeNewGeneration(parentGenomes, m_BarrierType, generation + 1, sensorTypeCount, actionTypeCount);
+        m_xPhylogeny->EndSpawn();
     } else {
         // Special case: there are no surviving parents: start the simulation over
         // from scratch with randomly-generated genomes
@@ -235,6 +327,24 @@ unsigned GenerationGenerator::spawnNewGeneration(
     return parentGenomes.size();
 }
 
+//-------------------------------------------------------------------------
+void GenerationGenerator::exportGenomeBank(unsigned generation, const std::vector<std::pair<PeepIndex, float>>& parents)
+{
+    if (parents.empty()) {
+        return;
+    }
+    // The parents are sorted by their scores, the best come first.
+    std::vector<GenomeBank::Record> records;
+    records.reserve(std::min<size_t>(parents.size(), m_Params.genomeBankExportCount));
+    for (const std::pair<PeepIndex, float>& parent : parents) {
+        if (records.size() == m_Params.genomeBankExportCount) {
+            break;
+        }
+        records.push_back({&m_PeepsPool[parent.first].genome, parent.second, generation, static_cast<unsigned>(m_Challenge)});
+    }
+    GenomeBank::Write(m_Params.logDir + "/genomes.bank", records);
+}
+
 // The epoch log contains one line per generation in a format that can be.
 void GenerationGenerator::appendEpochLog(unsigned generation, unsigned /*numberSurvivors*/, unsigned /*murderCount*/)
 {
@@ -3,6 +3,9 @@
 #include "Barriers/iBarriers.h"
 #include "Challenges/iChallenges.h"
 #include "Genome.h"
+#include "GenomeBank.h"
+#include "ParentSelection.h"
+#include "Phylogeny.h"
 #include "PheromoneSignals.h"
 
 class Analytics;
@@ -30,11 +33,17 @@ public:
         const Parameters& params,
         RandomUintGenerator& random,
         const eBarrierType& barrierType,
+        const eChallenges& challenge,
         std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers);
 
+    //! Maps the genome banks of Parameters::genomeBankImport. Their genomes seed
+    //! initializeGeneration0(), the best first. Unreadable banks are skipped.
+    void LoadGenomeBanks();
+
     // Requires that the grid, signals, and peeps containers have been allocated.
     // This will erase the grid and signal layers, then create a new population in
-    // the peeps container at random locations with random genomes.
+    // the peeps container at random locations with random genomes, or with the
+    // genomes of the loaded genome banks.
     void initializeGeneration0(
         eBarrierType barrierType,
         uint8_t sensorTypeCount,
@@ -59,17 +68,30 @@ public:
 
     //! Returns the oldest age in the generation.
     unsigned GetOldestAge() const { return m_OldestAge; }
+    //! Sets the oldest age, used to restore a checkpoint.
+    void SetOldestAge(unsigned age) { m_OldestAge = age; }
+    //! Returns the recorder of the births.
+    PhylogenyRecorder& GetPhylogeny() { return *m_xPhylogeny; }
+    const PhylogenyRecorder& GetPhylogeny() const { return *m_xPhylogeny; }
 private:
     // Returns by value a single genome with random genes.
-    Genetics::Genome makeRandomGenome();
+    Genetics::Genome makeRandomGenome(RandomUintGenerator& random) const;
+    //! Returns a copy of the \a n-th best genome of the loaded banks, cropped to
+    //! genomeMaxLength. Repeated copies of a bank genome get point mutations.
+    Genetics::Genome makeBankGenome(unsigned n, RandomUintGenerator& random) const;
+    //! Places all peeps at random empty locations in index order, see Peep::relocate().
+    void placePeeps();
+    //! Writes the genomes of the best \a parents to logDir/genomes.bank.
+    void exportGenomeBank(unsigned generation, const std::vector<std::pair<PeepIndex, float>>& parents);
 
     //! Requires a container with one or more parent genomes to choose from.
     //! Called from spawnNewGeneration(). This requires that the grid, signals, and
     //! peeps containers have been allocated. This will erase the grid and signal
     //! layers, then create a new population in the peeps container with random
     //! locations and genomes derived from the container of parent genomes.
+    //! The parent genomes are read in place, see m_SpareGenomes.
     void initializeNewGeneration(
-        const std::vector<Genetics::Genome>& parentGenomes,
+        const std::vector<const Genetics::Genome*>& parentGenomes,
         eBarrierType barrierType,
         unsigned generation,
         uint8_t sensorTypeCount,
@@ -78,8 +100,16 @@ private:
     //! This generates a child genome from one or two parent genomes.
     //! If the parameter p.sexualReproduction is true, two parents contribute
     //! genes to the offspring. The new genome may undergo mutation.
-    //! Must be called in single-thread mode between generations
-    Genetics::Genome generateChildGenome(const std::vector<Genetics::Genome> &parentGenomes);
+    //! \a primaryParent receives the parent the child genome is based on,
+    //! \a secondaryParent the one that contributed a slice, if any.
+    //! The child is written to \a genome, which keeps its capacity.
+    //! May be called from several threads, each with its own \a random.
+    void generateChildGenome(
+        const std::vector<const Genetics::Genome*> &parentGenomes,
+        Genetics::Genome& genome,
+        unsigned& primaryParent,
+        unsigned& secondaryParent,
+        RandomUintGenerator& random) const;
 
     //! The epoch log contains one line per generation in a format that can be.
     void appendEpochLog(unsigned generation, unsigned numberSurvivors, unsigned murderCount);
@@ -91,6 +121,14 @@ private:
     const Parameters&                                   m_Params;
     RandomUintGenerator&                                m_Random;
     const eBarrierType&                                 m_BarrierType;
+    const eChallenges&                                  m_Challenge;
     std::vector<std::unique_ptr<Barriers::iBarrier> >&  m_Barriers;
     unsigned                                            m_OldestAge{0};         ///< Stores the oldest age.
+    std::vector<const Genetics::Genome*>                m_ParentGenomes{};      ///< The parents' genomes, ordered like the parents.
+    std::vector<Genetics::Genome>                       m_SpareGenomes{};       ///< The other side of the peeps' genomes, indexed like the peeps. The
+                                                                                ///< children are written here, then swapped with the genomes they replace.
+    ParentSelection                                     m_ParentSelection;      ///< Draws the parents of the children.
+    std::vector<GenomeBank>                             m_GenomeBanks{};        ///< Mapped genome banks to seed from.
+    std::vector<std::pair<const GenomeBank*, size_t>>   m_BankGenomes{};        ///< Genomes of all banks, the best first.
+    std::unique_ptr<PhylogenyRecorder>                  m_xPhylogeny{};         ///< Records the lineage of every peep.
 };
\ No newline at end of file
@@ -4,7 +4,10 @@
 #include "PeepsPool.h"
 #include "SensorsActions.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
 namespace Genetics
@@ -97,15 +100,15 @@ float hammingDistanceBits(const Genome &genome1, const Genome &genome2)
 {
     assert(genome1.size() == genome2.size());
 
-    const char* p1 = (const char*)genome1.data();
-    const char* p2 = (const char*)genome2.data();
-    const unsigned numElements = genome1.size();
+    const unsigned char* p1 = (const unsigned char*)genome1.data();
+    const unsigned char* p2 = (const unsigned char*)genome2.data();
+    const unsigned numElements = std::min(genome1.size(), genome2.size()); // in bounds without asserts
     const unsigned bytesPerElement = sizeof(genome1[0]);
     const unsigned lengthBytes = numElements * bytesPerElement;
     const unsigned lengthBits = lengthBytes * 8;
     unsigned bitCount = 0;
 
-    for (unsigned index = 0; index < genome1.size(); ++p1, ++p2, ++index) {
+    for (unsigned index = 0; index < lengthBytes; ++p1, ++p2, ++index) {
         bitCount += __builtin_popcount(*p1 ^ *p2);
     }
 
@@ -123,14 +126,14 @@ float hammingDistanceBytes(const Genome &genome1, const Genome &genome2)
 {
     assert(genome1.size() == genome2.size());
 
-    const char* p1 = (const char*)genome1.data();
-    const char* p2 = (const char*)genome2.data();
-    const unsigned numElements = genome1.size();
+    const unsigned char* p1 = (const unsigned char*)genome1.data();
+    const unsigned char* p2 = (const unsigned char*)genome2.data();
+    const unsigned numElements = std::min(genome1.size(), genome2.size()); // in bounds without asserts
     const unsigned bytesPerElement = sizeof(genome1[0]);
     const unsigned lengthBytes = numElements * bytesPerElement;
     unsigned byteCount = 0;
 
-    for (unsigned index = 0; index < genome1.size(); ++p1, ++p2, ++index) {
+    for (unsigned index = 0; index < lengthBytes; ++p1, ++p2, ++index) {
         byteCount += (unsigned)(*p1 == *p2);
     }
 
@@ -152,11 +155,90 @@ float genomeSimilarity(const Genome &g1, const Genome &g2, const Parameters& par
     }
 }
 
+//---------------------------------------------------------------------------
+GenomeSketch makeGenomeSketch(const Genome& genome)
+{
+    constexpr unsigned cWords = GenomeSketch::cBits / 64;
+    constexpr unsigned cPlanes = 32;
+
+    // The votes are counted bit-sliced: plane i holds bit i of the vote count of each
+    // sketch bit, so a vote is a ripple-carry addition of its hash, 64 bits at once.
+    // The carries always run through the planes the count can reach, a loop ending
+    // with the carry would mispredict its exit.
+    std::array<std::array<uint64_t, cWords>, cPlanes> planes{};
+    const unsigned voterCount = 2 * genome.size();
+    unsigned planeCount = 1;
+    while (planeCount < cPlanes && (voterCount >> planeCount) != 0) {
+        ++planeCount;
+    }
+    auto vote = [&](uint64_t feature) {
+        for (unsigned word = 0; word < cWords; ++word) {
+            // splitmix64 finalizer of the feature, one stream per word
+            uint64_t hash = feature + (word + 1) * 0x9e3779b97f4a7c15ull;
+            hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+            hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+            hash ^= hash >> 31;
+            for (unsigned plane = 0; plane < planeCount; ++plane) {
+                const uint64_t carry = planes[plane][word] & hash;
+                planes[plane][word] ^= hash;
+                hash = carry;
+            }
+        }
+    };
+
+    for (const Gene& gene : genome) {
+        uint32_t bits;
+        std::memcpy(&bits, &gene, sizeof(bits));
+        // The whole gene, and its source and sink without the weight, so that genes
+        // differing in the weight only still share a vote.
+        vote(bits | (uint64_t(1) << 32));
+        vote((bits & 0xffff) | (uint64_t(2) << 32));
+    }
+
+    // A bit is set where more than half of the votes have it set. The counts are
+    // compared with the threshold from the top plane down, 64 bits at once.
+    const unsigned threshold = voterCount / 2;
+    GenomeSketch sketch{};
+    for (unsigned word = 0; word < cWords; ++word) {
+        uint64_t greater = 0;
+        uint64_t equal = ~uint64_t(0);
+        for (unsigned plane = planeCount; plane-- > 0;) {
+            if ((threshold >> plane) & 1) {
+                equal &= planes[plane][word];
+            } else {
+                greater |= equal & planes[plane][word];
+                equal &= ~planes[plane][word];
+            }
+        }
+        sketch.words[word] = greater;
+    }
+    return sketch;
+}
+
+//---------------------------------------------------------------------------
+float sketchSimilarity(const GenomeSketch& s1, const GenomeSketch& s2)
+{
+    // d differing bits of cBits estimate the angle pi * d / cBits.
+    static const std::array<float, GenomeSketch::cBits + 1> cCosines = [] {
+        std::array<float, GenomeSketch::cBits + 1> cosines{};
+        for (unsigned d = 0; d <= GenomeSketch::cBits; ++d) {
+            cosines[d] = std::max(0.0, std::cos(M_PI * d / GenomeSketch::cBits));
+        }
+        return cosines;
+    }();
+
+    unsigned differingBits = 0;
+    for (unsigned word = 0; word < s1.words.size(); ++word) {
+        differingBits += __builtin_popcountll(s1.words[word] ^ s2.words[word]);
+    }
+    return cCosines[differingBits];
+}
+
 //---------------------------------------------------------------------------
 void cropLength(Genome &genome, unsigned length, RandomUintGenerator& random)
 {
     if (genome.size() > length && length > 0) {
-        if (random() / (float)RANDOM_UINT_MAX < 0.5) {
+        if (random.uniform() < 0.5) {
             // trim front
             unsigned numberElementsToTrim = genome.size() - length;
             genome.erase(genome.begin(), genome.begin() + numberElementsToTrim);
@@ -185,8 +267,8 @@ Genetics::Gene makeRandomGene(RandomUintGenerator& random)
 void randomInsertDeletion(Genome &genome, RandomUintGenerator& random, const Parameters& params)
 {
     float probability = params.geneInsertionDeletionRate;
-    if (random() / (float)RANDOM_UINT_MAX < probability) {
-        if (random() / (float)RANDOM_UINT_MAX < params.deletionRatio) {
+    if (random.uniform() < probability) {
+        if (random.uniform() < params.deletionRatio) {
             // deletion
             if (genome.size() > 1) {
                 genome.erase(genome.begin() + random(0, genome.size() - 1));
@@ -202,41 +284,89 @@ void randomInsertDeletion(Genome &genome, RandomUintGenerator& random, const Par
 //---------------------------------------------------------------------------
 void randomBitFlip(Genome &genome, RandomUintGenerator& random)
 {
-    int method = 1;
-
-    unsigned byteIndex = random(0, genome.size() - 1) * sizeof(Gene);
-    unsigned elementIndex = random(0, genome.size() - 1);
-    uint8_t bitIndex8 = 1 << random(0, 7);
-
-    if (method == 0) {
-        ((uint8_t *)&genome[0])[byteIndex] ^= bitIndex8;
-    } else if (method == 1) {
-        float chance = random() / (float)RANDOM_UINT_MAX; // 0..1
-        if (chance < 0.2) { // sourceType
-            genome[elementIndex].sourceType ^= 1;
-        } else if (chance < 0.4) { // sinkType
-            genome[elementIndex].sinkType ^= 1;
-        } else if (chance < 0.6) { // sourceNum
-            genome[elementIndex].sourceNum ^= bitIndex8;
-        } else if (chance < 0.8) { // sinkNum
-            genome[elementIndex].sinkNum ^= bitIndex8;
-        } else { // weight
-            genome[elementIndex].weight ^= (1 << random(1, 15));
-        }
-    } else {
-        assert(false);
+    // Only the random numbers the chosen member needs are drawn.
+    Gene &gene = genome[random(0, genome.size() - 1)];
+    float chance = random.uniform(); // 0..1
+    if (chance < 0.2) { // sourceType
+        gene.sourceType ^= 1;
+    } else if (chance < 0.4) { // sinkType
+        gene.sinkType ^= 1;
+    } else if (chance < 0.6) { // sourceNum
+        gene.sourceNum ^= uint8_t(1 << random(0, 7));
+    } else if (chance < 0.8) { // sinkNum
+        gene.sinkNum ^= uint8_t(1 << random(0, 7));
+    } else { // weight
+        gene.weight ^= (1 << random(1, 15));
     }
 }
 
 //---------------------------------------------------------------------------
 void applyPointMutations(Genome &genome, RandomUintGenerator& random, const Parameters& params)
 {
-    unsigned numberOfGenes = genome.size();
-    while (numberOfGenes-- > 0) {
-        if ((random() / (float)RANDOM_UINT_MAX) < params.pointMutationRate) {
+    const unsigned numberOfGenes = genome.size();
+    const double rate = params.pointMutationRate;
+    if (rate <= 0.0 || numberOfGenes == 0) {
+        return;
+    }
+    if (rate >= 1.0) {
+        for (unsigned n = 0; n < numberOfGenes; ++n) {
             randomBitFlip(genome, random);
         }
+        return;
     }
+
+    // Each gene mutates with the rate. Instead of a random number per gene, the runs
+    // of unmutated genes are drawn, they are geometrically distributed. This takes one
+    // random number per mutation plus one, the count of mutations is the same binomial.
+    const double logNoMutation = std::log1p(-rate);
+    unsigned gene = 0;
+    for (;;) {
+        const double uniform = (random() + 1.0) / (double(RANDOM_UINT_MAX) + 1.0); // 0..1, never 0
+        const double skipped = std::floor(std::log(uniform) / logNoMutation);
+        if (skipped >= numberOfGenes - gene) {
+            break;
+        }
+        gene += unsigned(skipped) + 1;
+        randomBitFlip(genome, random);
+    }
+}
+
+//---------------------------------------------------------------------------
+void crossOver(Genome &child, const Genome &longer, const Genome &shorter, RandomUintGenerator& random)
+{
+    assert(!shorter.empty() && longer.size() >= shorter.size());
+
+    uint16_t index0 = random(0, shorter.size() - 1);
+    uint16_t index1 = random(0, shorter.size());
+    if (index0 > index1) {
+        std::swap(index0, index1);
+    }
+
+    // Trim to length = average length of parents
+    unsigned sum = longer.size() + shorter.size();
+    // If average length is not an integral number, add one half the time
+    if ((sum & 1) && (random() & 1)) {
+        ++sum;
+    }
+    // The trimmed genes are skipped instead of erased, drawn like cropLength() does.
+    const size_t length = sum / 2;
+    size_t first = 0;
+    if (longer.size() > length && random.uniform() < 0.5) {
+        first = longer.size() - length;
+    }
+    const size_t last = first + length;
+
+    child.resize(length);
+    auto copyBlock = [&](const Genome &source, size_t begin, size_t end) {
+        begin = std::max(begin, first);
+        end = std::min(end, last);
+        if (begin < end) {
+            std::copy(source.begin() + begin, source.begin() + end, child.begin() + (begin - first));
+        }
+    };
+    copyBlock(longer, 0, index0);
+    copyBlock(shorter, index0, index1);
+    copyBlock(longer, index1, longer.size());
 }
 
 //---------------------------------------------------------------------------
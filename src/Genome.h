@@ -2,6 +2,7 @@
 
 #include "Random.h"
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
@@ -84,6 +85,24 @@ constexpr float initialNeuronOutput() { return 0.5; }
 //! ToDo: optimize by approximation for long genomes
 float genomeSimilarity(const Genome& g1, const Genome& g2, const Parameters& params);
 
+//! Fixed-size SimHash of the genes of a genome. Each gene votes with a hash of
+//! itself and a hash of its source and sink, a bit is set where most votes have it
+//! set. The bits of two sketches differ with a probability proportional to the
+//! angle between the gene counts of the genomes.
+struct GenomeSketch
+{
+    static constexpr unsigned cBits = 256;
+    std::array<uint64_t, cBits / 64> words;
+};
+
+//! Computes the sketch of a genome, see Sensors::PrepareGeneticSimilarity().
+GenomeSketch makeGenomeSketch(const Genome& genome);
+
+//! Returns 0.0..1.0, the cosine similarity of the gene counts estimated from the
+//! differing bits of the sketches. Unrelated genomes are near 0.0, like with
+//! genomeSimilarity().
+float sketchSimilarity(const GenomeSketch& s1, const GenomeSketch& s2);
+
 void displaySampleGenomes(unsigned count, const PeepsPool& peeps, const Parameters& params);
 
 float averageGenomeLength(const PeepsPool& peeps, RandomUintGenerator& random, const Parameters& params);
@@ -110,6 +129,11 @@ void randomInsertDeletion(Genome &genome, RandomUintGenerator& random, const Par
 //! by the parameter p.pointMutationRate.
 void applyPointMutations(Genome &genome, RandomUintGenerator& random, const Parameters& params);
 
+//! Writes the child of two parents to \a child: the genes of the longer parent with a
+//! random slice of the shorter one's, cropped to the average length of the parents
+//! like cropLength() does. Each gene of the child is copied once.
+void crossOver(Genome &child, const Genome &longer, const Genome &shorter, RandomUintGenerator& random);
+
 //! Returns by value a single gene with random members.
 //! See genome.h for the width of the members.
 //! ToDo: don't assume the width of the members in gene.
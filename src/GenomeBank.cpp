@@ -0,0 +1,156 @@
+#include "GenomeBank.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char cMagic[8] = {'G', 'O', 'E', 'V', 'B', 'N', 'K', '1'};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t genomeCount;
+        uint64_t geneCount;
+    };
+
+    static_assert(sizeof(Header) == 32, "The header is part of the file format");
+    static_assert(sizeof(GenomeBank::Entry) == 24, "The entries are part of the file format");
+    static_assert(sizeof(Genetics::Gene) == 4, "The genes are part of the file format");
+}
+
+//-------------------------------------------------------------------------
+GenomeBank::GenomeBank(GenomeBank&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+//-------------------------------------------------------------------------
+GenomeBank& GenomeBank::operator=(GenomeBank&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        m_pMapping = std::exchange(other.m_pMapping, nullptr);
+        m_MappingSize = std::exchange(other.m_MappingSize, 0);
+        m_Count = std::exchange(other.m_Count, 0);
+        m_pEntries = std::exchange(other.m_pEntries, nullptr);
+        m_pGenes = std::exchange(other.m_pGenes, nullptr);
+    }
+    return *this;
+}
+
+//-------------------------------------------------------------------------
+GenomeBank::~GenomeBank()
+{
+    Close();
+}
+
+//-------------------------------------------------------------------------
+void GenomeBank::Close()
+{
+    if (m_pMapping) {
+        munmap(m_pMapping, m_MappingSize);
+    }
+    m_pMapping = nullptr;
+    m_MappingSize = 0;
+    m_Count = 0;
+    m_pEntries = nullptr;
+    m_pGenes = nullptr;
+}
+
+//-------------------------------------------------------------------------
+bool GenomeBank::Open(const std::string& path)
+{
+    Close();
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Couldn't open genome bank " << path << "." << std::endl;
+        return false;
+    }
+    struct stat status;
+    void* pMapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(Header)) {
+        pMapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (pMapping == MAP_FAILED) {
+        std::cerr << "Couldn't map genome bank " << path << "." << std::endl;
+        return false;
+    }
+    m_pMapping = pMapping;
+    m_MappingSize = status.st_size;
+
+    // The entries and genes follow the header, so the mapping alignment carries over.
+    const auto* pBytes = static_cast<const uint8_t*>(m_pMapping);
+    Header header;
+    std::memcpy(&header, pBytes, sizeof(header));
+    const size_t available = m_MappingSize - sizeof(Header);
+    bool valid = std::memcmp(header.magic, cMagic, sizeof(cMagic)) == 0
+        && header.version == cVersion
+        && header.genomeCount <= available / sizeof(Entry)
+        && header.geneCount == (available - header.genomeCount * sizeof(Entry)) / sizeof(Genetics::Gene);
+    if (valid) {
+        m_Count = header.genomeCount;
+        m_pEntries = reinterpret_cast<const Entry*>(pBytes + sizeof(Header));
+        m_pGenes = reinterpret_cast<const Genetics::Gene*>(pBytes + sizeof(Header) + m_Count * sizeof(Entry));
+        for (size_t n = 0; valid && n < m_Count; ++n) {
+            valid = m_pEntries[n].geneCount > 0 && m_pEntries[n].geneOffset <= header.geneCount
+                && m_pEntries[n].geneCount <= header.geneCount - m_pEntries[n].geneOffset;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Invalid genome bank " << path << "." << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+bool GenomeBank::Write(const std::string& path, const std::vector<Record>& records)
+{
+    const std::string tempPath = path + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Couldn't open genome bank " << tempPath << "." << std::endl;
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, cMagic, sizeof(cMagic));
+    header.version = cVersion;
+    header.genomeCount = records.size();
+    std::vector<Entry> entries;
+    entries.reserve(records.size());
+    for (const Record& record : records) {
+        entries.push_back({header.geneCount, uint32_t(record.genome->size()), record.fitness, record.generation, record.challenge});
+        header.geneCount += record.genome->size();
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+    for (const Record& record : records) {
+        file.write(reinterpret_cast<const char*>(record.genome->data()), record.genome->size() * sizeof(Genetics::Gene));
+    }
+    file.close();
+    if (!file) {
+        std::cerr << "Couldn't write genome bank " << tempPath << "." << std::endl;
+        return false;
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "Couldn't rename " << tempPath << " to " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Genome.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Genome bank file layout, native byte order:
+//   header:  "GOEVBNK1", uint32 version, uint32 reserved, uint64 genome count, uint64 gene count
+//   entries: genome count * GenomeBank::Entry
+//   genes:   gene count * Genetics::Gene, the genomes one after the other
+
+/*! \class GenomeBank
+    \brief Read-only view of a genome bank file.
+
+    The file is mapped into memory, the entries and genes are used in place. Banks
+    are written by GenerationGenerator from the best parents of a generation and
+    seed the first generation of later runs, see Parameters::genomeBankImport.
+*/
+class GenomeBank
+{
+public:
+    //! Describes one genome of the bank.
+    struct Entry {
+        uint64_t geneOffset;    ///< Index of the first gene in the gene array.
+        uint32_t geneCount;
+        float fitness;          ///< Score of the challenge, 0.0..1.0.
+        uint32_t generation;
+        uint32_t challenge;     ///< eChallenges
+    };
+    //! A genome to write.
+    struct Record {
+        const Genetics::Genome* genome;
+        float fitness;
+        unsigned generation;
+        unsigned challenge;
+    };
+
+    GenomeBank() = default;
+    GenomeBank(GenomeBank&& other) noexcept;
+    GenomeBank& operator=(GenomeBank&& other) noexcept;
+    GenomeBank(const GenomeBank&) = delete;
+    GenomeBank& operator=(const GenomeBank&) = delete;
+    ~GenomeBank();
+
+    //! Maps the bank file. Returns false if it is missing or no genome bank.
+    bool Open(const std::string& path);
+    size_t Size() const { return m_Count; }
+    const Entry& GetEntry(size_t n) const { return m_pEntries[n]; }
+    const Genetics::Gene* GetGenes(size_t n) const { return m_pGenes + m_pEntries[n].geneOffset; }
+
+    //! Writes the records as a bank to \a path, replacing it when complete.
+    static bool Write(const std::string& path, const std::vector<Record>& records);
+
+private:
+    static constexpr uint32_t cVersion = 1;
+
+    void Close();
+
+    void*                   m_pMapping{nullptr};
+    size_t                  m_MappingSize{};
+    size_t                  m_Count{};
+    const Entry*            m_pEntries{nullptr};
+    const Genetics::Gene*   m_pGenes{nullptr};
+};
@@ -5,10 +5,12 @@
 #include "Barriers/CircleBarrier.h"
 #include "Parameters.h"
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 
-constexpr uint16_t EMPTY = 0; // Index value 0 is reserved
-constexpr uint16_t BARRIER = 0xffff;
+constexpr PeepIndex EMPTY = 0; // Index value 0 is reserved
+constexpr PeepIndex BARRIER = std::numeric_limits<PeepIndex>::max();
 
 //-------------------------------------------------------------------------
 Grid::Grid(const Parameters& params, RandomUintGenerator& r)
@@ -21,8 +23,69 @@ Grid::Grid(const Parameters& params, RandomUintGenerator& r)
 //-------------------------------------------------------------------------
 void Grid::init()
 {
-    auto col = Column(m_Params.sizeY);
-    data = std::vector<Column>(m_Params.sizeX, col);
+    m_SizeX = m_Params.sizeX;
+    m_SizeY = m_Params.sizeY;
+    m_Sparse = m_Params.sparseWorld;
+    if (m_Sparse) {
+        data.clear();
+        m_Chunks.Init(m_SizeX, m_SizeY);
+    } else {
+        auto col = Column(m_Params.sizeY);
+        data = std::vector<Column>(m_Params.sizeX, col);
+        m_Chunks.Init(0, 0);
+    }
+    m_BarrierRasters = {};
+    m_DrawnBarrier = eBarrierType::NoOfTypes;
+}
+
+//-------------------------------------------------------------------------
+void Grid::zeroFill()
+{
+    if (m_Sparse) {
+        m_Chunks.Clear();
+    } else {
+        for (Column &column : data) {
+            column.zeroFill();
+        }
+    }
+    m_DrawnBarrier = eBarrierType::NoOfTypes;
+}
+
+//-------------------------------------------------------------------------
+void Grid::copyCells(PeepIndex* dest) const
+{
+    if (m_Sparse) {
+        std::fill(dest, dest + size_t(m_SizeX) * m_SizeY, EMPTY);
+        const unsigned chunkSize = ChunkedLayer<PeepIndex>::cChunkSize;
+        m_Chunks.ForEachResidentChunk([&](const ChunkedLayer<PeepIndex>::Chunk& chunk, uint16_t originX, uint16_t originY) {
+            // Chunks on the far edges reach beyond the world.
+            const unsigned width = std::min<unsigned>(chunkSize, m_SizeX - originX);
+            const unsigned height = std::min<unsigned>(chunkSize, m_SizeY - originY);
+            for (unsigned x = 0; x < width; ++x) {
+                std::copy_n(&chunk.cells[x * chunkSize], height, &dest[size_t(originX + x) * m_SizeY + originY]);
+            }
+        });
+        return;
+    }
+    for (uint16_t x = 0; x < m_SizeX; ++x) {
+        for (uint16_t y = 0; y < m_SizeY; ++y) {
+            dest[size_t(x) * m_SizeY + y] = data[x][y];
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void Grid::restoreCells(const PeepIndex* src, const std::vector<Coord>& centers)
+{
+    zeroFill();
+    for (uint16_t x = 0; x < m_SizeX; ++x) {
+        for (uint16_t y = 0; y < m_SizeY; ++y) {
+            if (src[size_t(x) * m_SizeY + y] != EMPTY) {
+                set(x, y, src[size_t(x) * m_SizeY + y]);
+            }
+        }
+    }
+    barrierCenters = centers;
 }
 
 //-------------------------------------------------------------------------
@@ -47,6 +110,7 @@ bool Grid::isBarrierAt(Coord loc) const
 void Grid::createBarrier(eBarrierType barrierType, std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers)
 {
     Barriers::createBarrier(barrierType, barriers, m_RandomGenerator, m_Params);
+    barrierCenters.clear();
     for (size_t i = 0; i < barriers.size(); ++i)
     {
         barriers[i]->Draw(BARRIER, m_Params, *this);
@@ -65,6 +129,78 @@ void Grid::createBarrier(eBarrierType barrierType, std::vector<std::unique_ptr<B
               break;
         }
     }
+    m_DrawnBarrier = barrierType;
+    cacheBarrierRaster(barrierType);
+}
+
+//-------------------------------------------------------------------------
+void Grid::cacheBarrierRaster(eBarrierType barrierType)
+{
+    BarrierRaster& raster = m_BarrierRasters[static_cast<size_t>(barrierType)];
+    if (raster.valid || Barriers::hasRandomLayout(barrierType)) {
+        return;
+    }
+    // Scans the whole grid once per barrier type, so peeps must not be placed yet.
+    raster.cells.clear();
+    if (m_Sparse) {
+        m_Chunks.ForEachResidentChunk([&raster](auto& chunk, uint16_t originX, uint16_t originY) {
+            for (int x = originX; x < originX + int(ChunkedLayer<PeepIndex>::cChunkSize); ++x) {
+                for (int y = originY; y < originY + int(ChunkedLayer<PeepIndex>::cChunkSize); ++y) {
+                    if (chunk.cells[ChunkedLayer<PeepIndex>::CellIndex(x, y)] == BARRIER) {
+                        raster.cells.push_back(Coord(int16_t(x), int16_t(y)));
+                    }
+                }
+            }
+        });
+    } else {
+        for (int16_t x = 0; x < m_SizeX; ++x) {
+            for (int16_t y = 0; y < m_SizeY; ++y) {
+                if (data[x][y] == BARRIER) {
+                    raster.cells.push_back(Coord(x, y));
+                }
+            }
+        }
+    }
+    raster.centers = barrierCenters;
+    raster.valid = true;
+}
+
+//-------------------------------------------------------------------------
+void Grid::resetBarrier(eBarrierType barrierType, std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers)
+{
+    if (barrierType == m_DrawnBarrier && !Barriers::hasRandomLayout(barrierType)) {
+        return;
+    }
+
+    // Clear the old layout. If it is unknown, the grid holds nothing but barriers.
+    if (m_DrawnBarrier == eBarrierType::NoOfTypes) {
+        zeroFill();
+    } else {
+        const BarrierRaster& oldRaster = m_BarrierRasters[static_cast<size_t>(m_DrawnBarrier)];
+        if (oldRaster.valid) {
+            for (Coord loc : oldRaster.cells) {
+                set(loc, EMPTY);
+            }
+        } else {
+            for (auto& barrier : barriers) {
+                barrier->Draw(EMPTY, m_Params, *this);
+            }
+        }
+    }
+
+    const BarrierRaster& raster = m_BarrierRasters[static_cast<size_t>(barrierType)];
+    if (!raster.valid) {
+        createBarrier(barrierType, barriers);
+        return;
+    }
+    // Constant layouts do not use the random generator, the barrier objects are
+    // only rebuilt for the UI.
+    Barriers::createBarrier(barrierType, barriers, m_RandomGenerator, m_Params);
+    for (Coord loc : raster.cells) {
+        set(loc, BARRIER);
+    }
+    barrierCenters = raster.centers;
+    m_DrawnBarrier = barrierType;
 }
 
 //-------------------------------------------------------------------------
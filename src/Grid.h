@@ -2,7 +2,9 @@
 
 #include "Barriers/iBarriers.h"
 #include "BasicTypes.h"
+#include "ChunkedLayer.h"
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -11,45 +13,50 @@
 class Parameters;
 class RandomUintGenerator;
 
-// Grid is a somewhat dumb 2D container of unsigned 16-bit values.
+// Grid is a somewhat dumb 2D container of PeepIndex values.
 // Grid understands that the elements are either EMPTY, BARRIER, or
 // otherwise an index value into the peeps container.
 // The elements are allocated and cleared to EMPTY in the ctor.
 // Prefer .at() and .set() for random element access. Or use Grid[x][y]
 // for direct access where the y index is the inner loop.
 // Element values are not otherwise interpreted by class Grid.
+// If Parameters::sparseWorld is set, the elements are stored in 64x64 chunks
+// allocated on first write instead, see ChunkedLayer. Direct access through
+// Grid[x][y] is only available in dense mode.
 class Grid {
 public:
     // Column order here allows us to access grid elements as data[x][y]
     // while thinking of x as column and y as row
     struct Column {
-        Column(uint16_t numRows) : data { std::vector<uint16_t>(numRows, 0) } { }
+        Column(uint16_t numRows) : data { std::vector<PeepIndex>(numRows, 0) } { }
         void zeroFill() { std::fill(data.begin(), data.end(), 0); }
-        uint16_t& operator[](uint16_t rowNum) { return data[rowNum]; }
-        uint16_t operator[](uint16_t rowNum) const { return data[rowNum]; }
+        PeepIndex& operator[](uint16_t rowNum) { return data[rowNum]; }
+        PeepIndex operator[](uint16_t rowNum) const { return data[rowNum]; }
         size_t size() const { return data.size(); }
     private:
-        std::vector<uint16_t> data;
+        std::vector<PeepIndex> data;
     };
 
     Grid(const Parameters& params, RandomUintGenerator& r);
 
     //! Allocates space for the 2D grid
     void init();
-    void zeroFill() { for (Column &column : data) column.zeroFill(); }
-    uint16_t sizeX() const { return data.size(); }
-    uint16_t sizeY() const { return data[0].size(); }
+    void zeroFill();
+    //! Frees the chunks without peeps or barriers. No-op in dense mode.
+    void releaseEmptyChunks() { if (m_Sparse) m_Chunks.ReleaseEmptyChunks(); }
+    uint16_t sizeX() const { return m_SizeX; }
+    uint16_t sizeY() const { return m_SizeY; }
     bool isInBounds(Coord loc) const { return loc.x >= 0 && loc.x < sizeX() && loc.y >= 0 && loc.y < sizeY(); }
     bool isEmptyAt(Coord loc) const;
     bool isBarrierAt(Coord loc) const;
     // Occupied means an agent is living there.
     bool isOccupiedAt(Coord loc) const;
     bool isBorder(Coord loc) const { return loc.x == 0 || loc.x == sizeX() - 1 || loc.y == 0 || loc.y == sizeY() - 1; }
-    uint16_t at(Coord loc) const { return data[loc.x][loc.y]; }
-    uint16_t at(uint16_t x, uint16_t y) const { return data[x][y]; }
+    PeepIndex at(Coord loc) const { return at(loc.x, loc.y); }
+    PeepIndex at(uint16_t x, uint16_t y) const { return m_Sparse ? m_Chunks.Get(x, y) : data[x][y]; }
 
-    void set(Coord loc, uint16_t val) { data[loc.x][loc.y] = val; }
-    void set(uint16_t x, uint16_t y, uint16_t val) { data[x][y] = val; }
+    void set(Coord loc, PeepIndex val) { set(loc.x, loc.y, val); }
+    void set(uint16_t x, uint16_t y, PeepIndex val) { if (m_Sparse) m_Chunks.Set(x, y, val); else data[x][y] = val; }
     //! Finds a random unoccupied location in the grid.
     Coord findEmptyLocation() const;
 
@@ -62,7 +69,19 @@ public:
     // This file typically is under constant development and change for
     // specific scenarios.
     void createBarrier(eBarrierType barrierType, std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers);
+    //! Generation transition counterpart of createBarrier(). Requires a grid that
+    //! holds nothing but the barriers of the last createBarrier() or resetBarrier() call.
+    //! The layout is left untouched if it has not changed. Otherwise the old barrier
+    //! cells are cleared, the whole grid if the old layout is unknown, and the new ones
+    //! restored from the raster cached for the barrier type, or drawn if the type has
+    //! a random layout or was not seen yet.
+    void resetBarrier(eBarrierType barrierType, std::vector<std::unique_ptr<Barriers::iBarrier> >& barriers);
     const std::vector<Coord> &getBarrierCenters() const { return barrierCenters; }
+    //! Copies the cells to \a dest, sizeX * sizeY values laid out column major.
+    void copyCells(PeepIndex* dest) const;
+    //! Counterpart of copyCells(), used to restore a checkpoint. The drawn barrier
+    //! layout is unknown afterwards, the next resetBarrier() redraws it from scratch.
+    void restoreCells(const PeepIndex* src, const std::vector<Coord>& centers);
     // Direct access:
     Column & operator[](uint16_t columnXNum) { return data[columnXNum]; }
     const Column & operator[](uint16_t columnXNum) const { return data[columnXNum]; }
@@ -71,5 +90,21 @@ private:
     RandomUintGenerator& m_RandomGenerator;
 
     std::vector<Column> data;
+    ChunkedLayer<PeepIndex> m_Chunks{};     ///< Storage in sparse mode, data is empty then.
+    bool m_Sparse{false};
+    uint16_t m_SizeX{};
+    uint16_t m_SizeY{};
     std::vector<Coord> barrierCenters;
+
+    //! Barrier cells and centers of a constant barrier layout.
+    struct BarrierRaster {
+        bool valid{false};
+        std::vector<Coord> cells{};
+        std::vector<Coord> centers{};
+    };
+    //! Stores the cells of the freshly drawn layout if its type has a constant layout.
+    void cacheBarrierRaster(eBarrierType barrierType);
+
+    std::array<BarrierRaster, static_cast<size_t>(eBarrierType::NoOfTypes)> m_BarrierRasters{};  ///< Indexed by the barrier type.
+    eBarrierType m_DrawnBarrier{eBarrierType::NoOfTypes};   ///< Layout on the grid, NoOfTypes if unknown.
 };
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "Parameters.h"
 
+#include "BasicTypes.h"
+#include "PheromoneSignals.h"
+
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 //---------------------------------------------------------------------------
@@ -31,8 +35,16 @@ void ParameterIO::SetDefaults()
     privParams.deletionRatio = 0.7;
     privParams.sexualReproduction = true;
     privParams.chooseParentsByFitness = true;
+    privParams.parentSelectionMethod = 0;
+    privParams.parentTournamentSize = 2;
     privParams.populationSensorRadius = 2.0;
     privParams.signalSensorRadius = 1;
+    privParams.precomputeSensorFields = false;
+    privParams.sparseWorld = false;
+    privParams.lazySignalFade = false;
+    privParams.spatialOrderStride = 0;
+    privParams.sensorPyramidRadius = 0.0;
+    privParams.signalDiffusion = 0.0;
     privParams.responsiveness = 0.5;
     privParams.responsivenessCurveKFactor = 2;
     privParams.longProbeDistance = 16;
@@ -43,11 +55,22 @@ void ParameterIO::SetDefaults()
     privParams.videoSaveFirstFrames = 0;
     privParams.displayScale = 1;
     privParams.agentSize = 2;
+    privParams.videoFormat = "png";
+    privParams.saveTrajectories = false;
+    privParams.trajectoryKeyframeStride = 100;
     privParams.genomeAnalysisStride = 1;
     privParams.displaySampleGenomes = 0;
     privParams.genomeComparisonMethod = 1;
+    privParams.exactGeneticSimilarity = false;
     privParams.updateGraphLog = false;
     privParams.updateGraphLogStride = 16;
+    privParams.checkpointStride = 0;
+    privParams.checkpointSnapshots = 0;
+    privParams.restoreCheckpoint = false;
+    privParams.genomeBankExportCount = 0;
+    privParams.genomeBankExportStride = 1;
+    privParams.genomeBankImport = "";
+    privParams.savePhylogeny = false;
     privParams.graphLogUpdateCommand = "/usr/bin/gnuplot --persist ./tools/graphlog.gp";
 }
 
@@ -148,6 +171,12 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "sizey" && isUint && uVal >= 2 && uVal <= (uint16_t)-1) {
             privParams.sizeY = uVal; break;
         }
+        else if (name == "sparseworld" && isBool) {
+            privParams.sparseWorld = bVal; break;
+        }
+        else if (name == "lazysignalfade" && isBool) {
+            privParams.lazySignalFade = bVal; break;
+        }
         else if (name == "challenge" && isUint && uVal < (uint16_t)-1) {
             privParams.challenge = uVal; break;
         }
@@ -163,7 +192,7 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "imagedir") {
             privParams.imageDir = val; break;
         }
-        else if (name == "population" && isUint && uVal > 0 && uVal < (uint32_t)-1) {
+        else if (name == "population" && isUint && uVal > 0 && uVal < std::numeric_limits<PeepIndex>::max()) {
             privParams.population = uVal; break;
         }
         else if (name == "stepspergeneration" && isUint && uVal > 0 && uVal < (uint16_t)-1) {
@@ -184,7 +213,7 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "numthreads" && isUint && uVal > 0 && uVal < (uint16_t)-1) {
             privParams.numThreads = uVal; break;
         }
-        else if (name == "signallayers" && isUint && uVal < (uint16_t)-1) {
+        else if (name == "signallayers" && isUint && uVal <= SIGNAL_LAYERS_MAX) {
             privParams.signalLayers = uVal; break;
         }
         else if (name == "genomemaxlength" && isUint && uVal > 0 && uVal < (uint16_t)-1) {
@@ -208,12 +237,30 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "chooseparentsbyfitness" && isBool) {
             privParams.chooseParentsByFitness = bVal; break;
         }
+        else if (name == "parentselectionmethod" && isUint && uVal <= 3) {
+            privParams.parentSelectionMethod = uVal; break;
+        }
+        else if (name == "parenttournamentsize" && isUint && uVal > 0) {
+            privParams.parentTournamentSize = uVal; break;
+        }
         else if (name == "populationsensorradius" && isFloat && dVal > 0.0) {
             privParams.populationSensorRadius = dVal; break;
         }
         else if (name == "signalsensorradius" && isFloat && dVal > 0.0) {
             privParams.signalSensorRadius = dVal; break;
         }
+        else if (name == "precomputesensorfields" && isBool) {
+            privParams.precomputeSensorFields = bVal; break;
+        }
+        else if (name == "spatialorderstride" && isUint) {
+            privParams.spatialOrderStride = uVal; break;
+        }
+        else if (name == "sensorpyramidradius" && isFloat && dVal >= 0.0) {
+            privParams.sensorPyramidRadius = dVal; break;
+        }
+        else if (name == "signaldiffusion" && isFloat && dVal >= 0.0 && dVal <= 1.0) {
+            privParams.signalDiffusion = dVal; break;
+        }
         else if (name == "responsiveness" && isFloat && dVal >= 0.0) {
             privParams.responsiveness = dVal; break;
         }
@@ -244,6 +291,15 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "agentsize" && isFloat && dVal > 0.0) {
             privParams.agentSize = dVal; break;
         }
+        else if (name == "videoformat" && (val == "png" || val == "raw")) {
+            privParams.videoFormat = val; break;
+        }
+        else if (name == "savetrajectories" && isBool) {
+            privParams.saveTrajectories = bVal; break;
+        }
+        else if (name == "trajectorykeyframestride" && isUint && uVal > 0) {
+            privParams.trajectoryKeyframeStride = uVal; break;
+        }
         else if (name == "genomeanalysisstride" && isUint && uVal > 0) {
             privParams.genomeAnalysisStride = uVal; break;
         }
@@ -256,6 +312,9 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "genomecomparisonmethod" && isUint) {
             privParams.genomeComparisonMethod = uVal; break;
         }
+        else if (name == "exactgeneticsimilarity" && isBool) {
+            privParams.exactGeneticSimilarity = bVal; break;
+        }
         else if (name == "updategraphlog" && isBool) {
             privParams.updateGraphLog = bVal; break;
         }
@@ -265,6 +324,27 @@ void ParameterIO::ingestParameter(std::string name, std::string val)
         else if (name == "updategraphlogstride" && val == "videoStride") {
             privParams.updateGraphLogStride = privParams.videoStride; break;
         }
+        else if (name == "checkpointstride" && isUint) {
+            privParams.checkpointStride = uVal; break;
+        }
+        else if (name == "checkpointsnapshots" && isUint) {
+            privParams.checkpointSnapshots = uVal; break;
+        }
+        else if (name == "restorecheckpoint" && isBool) {
+            privParams.restoreCheckpoint = bVal; break;
+        }
+        else if (name == "genomebankexportcount" && isUint) {
+            privParams.genomeBankExportCount = uVal; break;
+        }
+        else if (name == "genomebankexportstride" && isUint && uVal > 0) {
+            privParams.genomeBankExportStride = uVal; break;
+        }
+        else if (name == "genomebankimport") {
+            privParams.genomeBankImport = val; break;
+        }
+        else if (name == "savephylogeny" && isBool) {
+            privParams.savePhylogeny = bVal; break;
+        }
         else {
             std::cout << "Invalid param: " << name << " = " << val << std::endl;
         }
@@ -288,9 +368,14 @@ void ParameterIO::WriteToConfigFile(const std::string& filename)
         file << "deletionratio = " << privParams.deletionRatio << std::endl;
         file << "sexualreproduction = " << privParams.sexualReproduction << std::endl;
         file << "chooseparentsbyfitness = " << privParams.chooseParentsByFitness << std::endl;
-        file << "chooseparentsbyfitness = " << privParams.chooseParentsByFitness << std::endl;
+        file << "parentselectionmethod = " << privParams.parentSelectionMethod << std::endl;
+        file << "parenttournamentsize = " << privParams.parentTournamentSize << std::endl;
         file << "populationsensorradius = " << privParams.populationSensorRadius << std::endl;
         file << "signalsensorradius = " << privParams.signalSensorRadius << std::endl;
+        file << "precomputesensorfields = " << privParams.precomputeSensorFields << std::endl;
+        file << "sensorpyramidradius = " << privParams.sensorPyramidRadius << std::endl;
+        file << "spatialorderstride = " << privParams.spatialOrderStride << std::endl;
+        file << "signaldiffusion = " << privParams.signalDiffusion << std::endl;
         file << "responsiveness = " << privParams.responsiveness << std::endl;
         file << "responsivenesscurvekfactor = " << privParams.responsivenessCurveKFactor << std::endl;
         file << "longprobedistance = " << privParams.longProbeDistance << std::endl;
@@ -301,17 +386,30 @@ void ParameterIO::WriteToConfigFile(const std::string& filename)
         file << "videosavefirstframes = " << privParams.videoSaveFirstFrames << std::endl;
         file << "displayscale = " << privParams.displayScale << std::endl;
         file << "agentsize = " << privParams.agentSize << std::endl;
+        file << "videoformat = " << privParams.videoFormat << std::endl;
+        file << "savetrajectories = " << privParams.saveTrajectories << std::endl;
+        file << "trajectorykeyframestride = " << privParams.trajectoryKeyframeStride << std::endl;
         file << "genomeanalysisstride = " << privParams.genomeAnalysisStride << std::endl;
         file << "displaysamplegenomes = " << privParams.displaySampleGenomes << std::endl;
         file << "genomecomparisonmethod = " << privParams.genomeComparisonMethod << std::endl;
+        file << "exactgeneticsimilarity = " << privParams.exactGeneticSimilarity << std::endl;
         file << "updategraphlog = " << privParams.updateGraphLog << std::endl;
         file << "updategraphlogstride = " << privParams.updateGraphLogStride << std::endl;
+        file << "checkpointstride = " << privParams.checkpointStride << std::endl;
+        file << "checkpointsnapshots = " << privParams.checkpointSnapshots << std::endl;
+        file << "restorecheckpoint = " << privParams.restoreCheckpoint << std::endl;
+        file << "genomebankexportcount = " << privParams.genomeBankExportCount << std::endl;
+        file << "genomebankexportstride = " << privParams.genomeBankExportStride << std::endl;
+        file << "genomebankimport = " << privParams.genomeBankImport << std::endl;
+        file << "savephylogeny = " << privParams.savePhylogeny << std::endl;
         file << "challenge = " << privParams.challenge << std::endl;
         file << "barriertype = " << privParams.barrierType << std::endl;
         file << "replacebarriertype = " << privParams.replaceBarrierType << std::endl;
         file << "replacebarriertypegenerationnumber = " << privParams.replaceBarrierTypeGenerationNumber << std::endl;
         file << "sizex = " << privParams.sizeX << std::endl;
         file << "sizey = " << privParams.sizeY << std::endl;
+        file << "sparseworld = " << privParams.sparseWorld << std::endl;
+        file << "lazysignalfade = " << privParams.lazySignalFade << std::endl;
         file << "genomeinitiallengthmin = " << privParams.genomeInitialLengthMin << std::endl;
         file << "genomeinitiallengthmax = " << privParams.genomeInitialLengthMax << std::endl;
         file << "logdir = " << privParams.logDir << std::endl;
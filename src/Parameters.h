@@ -19,8 +19,14 @@ struct Parameters {
     double deletionRatio{};                         // 0.0..1.0
     bool sexualReproduction{};    
     bool chooseParentsByFitness{};    
+    unsigned parentSelectionMethod{};               // 0 = pairs by score order, 1 = roulette, 2 = tournament, 3 = rank
+    unsigned parentTournamentSize{2};               // > 0
     float populationSensorRadius{1};                // > 0.0
     unsigned signalSensorRadius{1};                 // > 0
+    bool precomputeSensorFields{};
+    unsigned spatialOrderStride{};                  // >= 0, 0 disables
+    float sensorPyramidRadius{};                    // >= 0.0, 0.0 disables
+    float signalDiffusion{};                        // 0.0..1.0, 0.0 disables
     float responsiveness{};                         // >= 0.0
     unsigned responsivenessCurveKFactor{1};         // 1, 2, 3, or 4
     unsigned longProbeDistance{1};                  // > 0
@@ -31,11 +37,22 @@ struct Parameters {
     unsigned videoSaveFirstFrames{};                // >= 0, overrides videoStride
     unsigned displayScale{};    
     unsigned agentSize{};   
+    std::string videoFormat{};                      // "png" or "raw"
+    bool saveTrajectories{};
+    unsigned trajectoryKeyframeStride{100};         // > 0
     unsigned genomeAnalysisStride{1};               // > 0
     unsigned displaySampleGenomes{};                // >= 0
     unsigned genomeComparisonMethod{};              // 0 = Jaro-Winkler; 1 = Hamming
+    bool exactGeneticSimilarity{};
     bool updateGraphLog{};    
     unsigned updateGraphLogStride{1};               // > 0
+    unsigned checkpointStride{};                    // >= 0, 0 disables
+    unsigned checkpointSnapshots{};                 // >= 0, 0 writes in the sim thread
+    bool restoreCheckpoint{};
+    unsigned genomeBankExportCount{};               // >= 0, 0 disables
+    unsigned genomeBankExportStride{1};             // > 0
+    std::string genomeBankImport{};                 // comma-separated paths, empty disables
+    bool savePhylogeny{};
     unsigned challenge{};   
     unsigned barrierType{};                         // >= 0
     unsigned replaceBarrierType{};                  // >= 0
@@ -44,6 +61,8 @@ struct Parameters {
     // These must not change after initialization
     uint16_t sizeX{2};                              // 2..0x10000
     uint16_t sizeY{2};                              // 2..0x10000
+    bool sparseWorld{};
+    bool lazySignalFade{};
     unsigned genomeInitialLengthMin{1};             // > 0 and < genomeInitialLengthMax
     unsigned genomeInitialLengthMax{1};             // > 0 and < genomeInitialLengthMin
     std::string logDir{};
@@ -0,0 +1,126 @@
+#include "ParentSelection.h"
+
+#include "Parameters.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cassert>
+
+//-------------------------------------------------------------------------
+ParentSelection::ParentSelection(const Parameters& params)
+    : m_Params(params)
+{
+
+}
+
+//-------------------------------------------------------------------------
+void ParentSelection::Prepare(const std::vector<std::pair<PeepIndex, float>>& parents)
+{
+    m_Count = parents.size();
+    m_Method = m_Params.parentSelectionMethod < static_cast<unsigned>(eMethod::Count)
+        ? static_cast<eMethod>(m_Params.parentSelectionMethod) : eMethod::Pairs;
+    if (!m_Params.chooseParentsByFitness || m_Count == 0) {
+        return;
+    }
+
+    if (m_Method == eMethod::Roulette) {
+        m_Weights.resize(m_Count);
+        for (unsigned n = 0; n < m_Count; ++n) {
+            m_Weights[n] = std::max(parents[n].second, 0.0f);
+        }
+        BuildAliasTable();
+    } else if (m_Method == eMethod::Rank) {
+        // The parents are sorted, the best gets the weight m_Count, the worst 1.
+        m_Weights.resize(m_Count);
+        for (unsigned n = 0; n < m_Count; ++n) {
+            m_Weights[n] = m_Count - n;
+        }
+        BuildAliasTable();
+    }
+}
+
+//-------------------------------------------------------------------------
+void ParentSelection::BuildAliasTable()
+{
+    double sum = 0.0;
+    for (double weight : m_Weights) {
+        sum += weight;
+    }
+    m_Probabilities.resize(m_Count);
+    m_Aliases.resize(m_Count);
+    m_Small.clear();
+    m_Large.clear();
+    for (unsigned n = 0; n < m_Count; ++n) {
+        // All scores 0.0 select uniformly.
+        m_Weights[n] = sum > 0.0 ? m_Weights[n] * m_Count / sum : 1.0;
+        m_Aliases[n] = n;
+        (m_Weights[n] < 1.0 ? m_Small : m_Large).push_back(n);
+    }
+
+    // Each slot below the average is filled up from a slot above it, which may drop
+    // below the average in turn.
+    while (!m_Small.empty() && !m_Large.empty()) {
+        const unsigned small = m_Small.back();
+        const unsigned large = m_Large.back();
+        m_Small.pop_back();
+        m_Probabilities[small] = m_Weights[small];
+        m_Aliases[small] = large;
+        m_Weights[large] = (m_Weights[large] + m_Weights[small]) - 1.0;
+        if (m_Weights[large] < 1.0) {
+            m_Large.pop_back();
+            m_Small.push_back(large);
+        }
+    }
+    // The rest is at the average up to rounding errors.
+    for (unsigned slot : m_Large) {
+        m_Probabilities[slot] = 1.0f;
+    }
+    for (unsigned slot : m_Small) {
+        m_Probabilities[slot] = 1.0f;
+    }
+}
+
+//-------------------------------------------------------------------------
+unsigned ParentSelection::DrawFromAliasTable(RandomUintGenerator& random) const
+{
+    const unsigned slot = random(0, m_Count - 1);
+    return random.uniform() < m_Probabilities[slot] ? slot : m_Aliases[slot];
+}
+
+//-------------------------------------------------------------------------
+unsigned ParentSelection::DrawFromTournament(RandomUintGenerator& random) const
+{
+    // The parents are sorted, the best of the contestants is the one in front.
+    unsigned best = random(0, m_Count - 1);
+    for (unsigned n = 1; n < m_Params.parentTournamentSize; ++n) {
+        best = std::min(best, random(0, m_Count - 1));
+    }
+    return best;
+}
+
+//-------------------------------------------------------------------------
+void ParentSelection::Draw(unsigned& parent1, unsigned& parent2, RandomUintGenerator& random) const
+{
+    assert(m_Count > 0);
+
+    if (!m_Params.chooseParentsByFitness || m_Count == 1) {
+        parent1 = random(0, m_Count - 1);
+        parent2 = random(0, m_Count - 1);
+        return;
+    }
+    switch (m_Method) {
+    case eMethod::Roulette:
+    case eMethod::Rank:
+        parent1 = DrawFromAliasTable(random);
+        parent2 = DrawFromAliasTable(random);
+        break;
+    case eMethod::Tournament:
+        parent1 = DrawFromTournament(random);
+        parent2 = DrawFromTournament(random);
+        break;
+    default:
+        parent1 = random(1, m_Count - 1);
+        parent2 = random(0, parent1 - 1);
+        break;
+    }
+}
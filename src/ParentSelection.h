@@ -0,0 +1,56 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <utility>
+#include <vector>
+
+class Parameters;
+class RandomUintGenerator;
+
+/*! \class ParentSelection
+    \brief Draws the parents of the children of a generation in constant time.
+
+    Prepare() builds the tables once per generation from the parents and their challenge
+    scores, Draw() only reads them. The threads of the reproduction may draw at once,
+    each with its own generator. Roulette and rank selection draw from an alias table
+    built with Vose's method in O(n): each slot holds one parent, the probability to
+    keep it and an alias taken otherwise, so a draw costs two random numbers.
+*/
+class ParentSelection
+{
+public:
+    //! Selection methods, see Parameters::parentSelectionMethod.
+    enum class eMethod : unsigned {
+        Pairs = 0,      ///< The first parent anywhere but the best, the second better than the first.
+        Roulette,       ///< Proportional to the score.
+        Tournament,     ///< The best of parentTournamentSize uniform draws.
+        Rank,           ///< Proportional to the count of parents scored lower, plus one.
+        Count
+    };
+
+    ParentSelection(const Parameters& params);
+
+    //! Builds the tables for \a parents, sorted by their score with the best first.
+    //! Called in single-thread mode before the children are spawned.
+    void Prepare(const std::vector<std::pair<PeepIndex, float>>& parents);
+    //! Returns the positions of the two parents of a child in the parents of Prepare().
+    //! The method applies if Parameters::chooseParentsByFitness is set, otherwise every
+    //! parent is equally likely.
+    void Draw(unsigned& parent1, unsigned& parent2, RandomUintGenerator& random) const;
+
+private:
+    //! Fills the alias table from m_Weights.
+    void BuildAliasTable();
+    unsigned DrawFromAliasTable(RandomUintGenerator& random) const;
+    unsigned DrawFromTournament(RandomUintGenerator& random) const;
+
+    const Parameters&       m_Params;
+    eMethod                 m_Method{eMethod::Pairs};
+    unsigned                m_Count{};
+    std::vector<double>     m_Weights{};        ///< Scaled to an average of 1.0 while building.
+    std::vector<float>      m_Probabilities{};  ///< Of keeping the parent of a slot.
+    std::vector<unsigned>   m_Aliases{};
+    std::vector<unsigned>   m_Small{};          ///< Slots below the average while building.
+    std::vector<unsigned>   m_Large{};
+};
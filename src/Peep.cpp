@@ -5,52 +5,39 @@
 #include "Parameters.h"
 #include "PeepsPool.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 
-
-//-------------------------------------------------------------------------
-Peep::Peep(const Parameters& params, const Grid& grid)
-    : m_Params(params)
-    , m_Grid(grid)
-{}
+// A scan of the hot fields reads one cache line per peep. Adding a hot field that does
+// not fit means moving a colder one behind birthLoc.
+static_assert(offsetof(Peep, planTimeUpdateStep) + sizeof(Peep::planTimeUpdateStep) <= 64,
+              "The hot fields of a peep must fit in its first cache line");
+static_assert(alignof(Peep) == 64, "A peep must start on a cache line");
 
 //-------------------------------------------------------------------------
 void Peep::initialize(
-    uint16_t index_,
-    Coord loc_,
+    PeepIndex index_,
     Genetics::Genome &&genome_,
-    RandomUintGenerator& random,
     uint8_t sensorTypeCount,
     uint8_t actionTypeCount,
-    Grid& grid)
+    const Parameters& params)
 {
     index = index_;
-    loc = loc_;
-    plannedLoc = loc_;
-    plannedSimStep = 0;
-    planTimeUpdateStep = 0;
-    birthLoc = loc_;
-    grid.set(loc_, index_);
     age = 0;
-    oscPeriod = 34; // ToDo !!! define a constant
-    alive = true;
-    survivedToNextGen = false;
-    lastMoveDir = Dir::random8(random);
-    responsiveness = 0.5; // range 0.0..1.0
-    longProbeDist = m_Params.longProbeDistance;
-    challengeBits = 0; // will be set non zero when some task gets accomplished
     genome = std::move(genome_);
-    createWiringFromGenome(sensorTypeCount, actionTypeCount);
+    createWiringFromGenome(sensorTypeCount, actionTypeCount, params);
 }
 
 //-------------------------------------------------------------------------
 void Peep::relocate(
     Coord loc_,
     RandomUintGenerator& random,
-    Grid& grid)
+    Grid& grid,
+    const Parameters& params)
 {
     loc = loc_;
     plannedLoc = loc_;
@@ -63,7 +50,7 @@ void Peep::relocate(
     survivedToNextGen = false;
     lastMoveDir = Dir::random8(random);
     responsiveness = 0.5; // range 0.0..1.0
-    longProbeDist = m_Params.longProbeDistance;
+    longProbeDist = params.longProbeDistance;
     challengeBits = 0; // will be set non zero when some task gets accomplished
 }
 
@@ -72,7 +59,8 @@ void Peep::makeRenumberedConnectionList(
     ConnectionList &connectionList, 
     const Genetics::Genome &genome,
     uint8_t sensorTypeCount,
-    uint8_t actionTypeCount)
+    uint8_t actionTypeCount,
+    const Parameters& params)
 {
     connectionList.clear();
     for (auto const &gene : genome) {
@@ -80,13 +68,13 @@ void Peep::makeRenumberedConnectionList(
         auto &conn = connectionList.back();
 
         if (conn.sourceType == Genetics::NEURON) {
-            conn.sourceNum %= m_Params.maxNumberNeurons;
+            conn.sourceNum %= params.maxNumberNeurons;
         } else {
             conn.sourceNum %= sensorTypeCount;
         }
 
         if (conn.sinkType == Genetics::NEURON) {
-            conn.sinkNum %= m_Params.maxNumberNeurons;
+            conn.sinkNum %= params.maxNumberNeurons;
         } else {
             conn.sinkNum %= actionTypeCount;
         }
@@ -94,43 +82,27 @@ void Peep::makeRenumberedConnectionList(
 }
 
 //-------------------------------------------------------------------------
-void Peep::makeNodeList(NodeMap &nodeMap, const ConnectionList &connectionList)
+void Peep::makeNodeList(NodeMap &nodeMap, const ConnectionList &connectionList, [[maybe_unused]] const Parameters& params)
 {
-    nodeMap.clear();
+    nodeMap.fill({});
 
     for (const auto &conn : connectionList) {
         if (conn.sinkType == Genetics::NEURON) {
-            auto it = nodeMap.find(conn.sinkNum);
-            if (it == nodeMap.end()) {
-                assert(conn.sinkNum < m_Params.maxNumberNeurons);
-                nodeMap.insert({conn.sinkNum, {}});
-                it = nodeMap.find(conn.sinkNum);
-                assert(it->first < m_Params.maxNumberNeurons);
-                it->second.numOutputs = 0;
-                it->second.numSelfInputs = 0;
-                it->second.numInputsFromSensorsOrOtherNeurons = 0;
-            }
+            assert(conn.sinkNum < params.maxNumberNeurons);
+            Node &node = nodeMap[conn.sinkNum];
+            node.used = true;
 
             if (conn.sourceType == Genetics::NEURON && (conn.sourceNum == conn.sinkNum)) {
-                ++(it->second.numSelfInputs);
+                ++node.numSelfInputs;
             } else {
-                ++(it->second.numInputsFromSensorsOrOtherNeurons);
+                ++node.numInputsFromSensorsOrOtherNeurons;
             }
-            assert(nodeMap.count(conn.sinkNum) == 1);
         }
         if (conn.sourceType == Genetics::NEURON) {
-            auto it = nodeMap.find(conn.sourceNum);
-            if (it == nodeMap.end()) {
-                assert(conn.sourceNum < m_Params.maxNumberNeurons);
-                nodeMap.insert({conn.sourceNum, {}});
-                it = nodeMap.find(conn.sourceNum);
-                assert(it->first < m_Params.maxNumberNeurons);
-                it->second.numOutputs = 0;
-                it->second.numSelfInputs = 0;
-                it->second.numInputsFromSensorsOrOtherNeurons = 0;
-            }
-            ++(it->second.numOutputs);
-            assert(nodeMap.count(conn.sourceNum) == 1);
+            assert(conn.sourceNum < params.maxNumberNeurons);
+            Node &node = nodeMap[conn.sourceNum];
+            node.used = true;
+            ++node.numOutputs;
         }
     }
 }
@@ -138,68 +110,74 @@ void Peep::makeNodeList(NodeMap &nodeMap, const ConnectionList &connectionList)
 //-------------------------------------------------------------------------
 void Peep::removeConnectionsToNeuron(ConnectionList &connections, NodeMap &nodeMap, uint16_t neuronNumber)
 {
-    for (auto itConn = connections.begin(); itConn != connections.end(); ) {
+    // Compacts the remaining connections in place, keeping their order.
+    auto itKept = connections.begin();
+    for (auto itConn = connections.begin(); itConn != connections.end(); ++itConn) {
         if (itConn->sinkType == Genetics::NEURON && itConn->sinkNum == neuronNumber) {
             // Remove the connection. If the connection source is from another
             // neuron, also decrement the other neuron's numOutputs:
             if (itConn->sourceType == Genetics::NEURON) {
                 --(nodeMap[itConn->sourceNum].numOutputs);
             }
-            itConn = connections.erase(itConn);
         } else {
-            ++itConn;
+            *itKept++ = *itConn;
         }
     }
+    connections.erase(itKept, connections.end());
 }
 
 //-------------------------------------------------------------------------
-void Peep::cullUselessNeurons(ConnectionList &connections, NodeMap &nodeMap)
+void Peep::cullUselessNeurons(ConnectionList &connections, NodeMap &nodeMap, [[maybe_unused]] const Parameters& params)
 {
     bool allDone = false;
     while (!allDone) {
         allDone = true;
-        for (auto itNeuron = nodeMap.begin(); itNeuron != nodeMap.end(); ) {
-            assert(itNeuron->first < m_Params.maxNumberNeurons);
+        for (uint16_t neuronNumber = 0; neuronNumber < cMaxNeurons; ++neuronNumber) {
+            Node &node = nodeMap[neuronNumber];
             // We're looking for neurons with zero outputs, or neurons that feed itself
             // and nobody else:
-            if (itNeuron->second.numOutputs == itNeuron->second.numSelfInputs) {  // could be 0
+            if (node.used && node.numOutputs == node.numSelfInputs) {  // could be 0
+                assert(neuronNumber < params.maxNumberNeurons);
                 allDone = false;
                 // Find and remove connections from sensors or other neurons
-                removeConnectionsToNeuron(connections, nodeMap, itNeuron->first);
-                itNeuron = nodeMap.erase(itNeuron);
-            } else {
-                ++itNeuron;
+                removeConnectionsToNeuron(connections, nodeMap, neuronNumber);
+                node.used = false;
             }
         }
     }
 }
 
 //-------------------------------------------------------------------------
-void Peep::createWiringFromGenome(uint8_t sensorTypeCount, uint8_t actionTypeCount)
+void Peep::createWiringFromGenome(uint8_t sensorTypeCount, uint8_t actionTypeCount, const Parameters& params)
 {
-    NodeMap nodeMap;  // list of neurons and their number of inputs and outputs
-    ConnectionList connectionList; // synaptic connections
+    thread_local NodeMap nodeMap;  // list of neurons and their number of inputs and outputs
+    thread_local ConnectionList connectionList; // synaptic connections
 
     // Convert the indiv's genome to a renumbered connection list
-    makeRenumberedConnectionList(connectionList, genome, sensorTypeCount, actionTypeCount);
+    makeRenumberedConnectionList(connectionList, genome, sensorTypeCount, actionTypeCount, params);
 
     // Make a node (neuron) list from the renumbered connection list
-    makeNodeList(nodeMap, connectionList);
+    makeNodeList(nodeMap, connectionList, params);
 
     // Find and remove neurons that don't feed anything or only feed themself.
     // This reiteratively removes all connections to the useless neurons.
-    cullUselessNeurons(connectionList, nodeMap);
+    cullUselessNeurons(connectionList, nodeMap, params);
 
     // The neurons map now has all the referenced neurons, their neuron numbers, and
     // the number of outputs for each neuron. Now we'll renumber the neurons
     // starting at zero.
 
-    assert(nodeMap.size() <= m_Params.maxNumberNeurons);
     uint16_t newNumber = 0;
-    for (auto & node : nodeMap) {
-        assert(node.second.numOutputs != 0);
-        node.second.remappedNumber = newNumber++;
+    unsigned neuronCount = 0;
+    for (uint16_t neuronNumber = 0; neuronNumber < cMaxNeurons; ++neuronNumber) {
+        Node &node = nodeMap[neuronNumber];
+        if (node.used) {
+            assert(node.numOutputs != 0);
+            node.remappedNumber = newNumber++;
+            neuronCount = neuronNumber + 1;
+        }
     }
+    assert(newNumber <= params.maxNumberNeurons);
 
     // Create the peep's connection list in two passes:
     // First the connections to neurons, then the connections to actions.
@@ -233,12 +211,13 @@ void Peep::createWiringFromGenome(uint8_t sensorTypeCount, uint8_t actionTypeCou
         }
     }
 
-    // Create the indiv's neural node list
+    // Create the indiv's neural node list. It spans the neuron numbers up to the
+    // highest remaining one, the culled numbers in between are undriven.
     nnet.neurons.clear();
-    for (unsigned neuronNum = 0; neuronNum < nodeMap.size(); ++neuronNum) {
+    for (unsigned neuronNum = 0; neuronNum < neuronCount; ++neuronNum) {
         nnet.neurons.push_back( {} );
         nnet.neurons.back().output = Genetics::initialNeuronOutput();
-        nnet.neurons.back().driven = (nodeMap[neuronNum].numInputsFromSensorsOrOtherNeurons != 0);
+        nnet.neurons.back().driven = nodeMap[neuronNum].used && (nodeMap[neuronNum].numInputsFromSensorsOrOtherNeurons != 0);
     }
 }
 
@@ -249,6 +228,8 @@ std::array<float, Actions::eType::NUM_ACTIONS> Peep::feedForward(
     const PeepsPool& peeps,
     const PheromoneSignals& pheromoneSignals,
     const Sensors& sensors,
+    const Grid& grid,
+    const Parameters& params,
     RandomUintGenerator& random)
 {
     // This container is used to return values for all the action outputs. This array
@@ -263,7 +244,9 @@ std::array<float, Actions::eType::NUM_ACTIONS> Peep::feedForward(
     actionLevels.fill(0.0); // undriven actions default to value 0.0
 
     // Weighted inputs to each neuron are summed in neuronAccumulators[]
-    std::vector<float> neuronAccumulators(nnet.neurons.size(), 0.0);
+    std::array<float, cMaxNeurons> neuronAccumulators;
+    assert(nnet.neurons.size() <= cMaxNeurons);
+    std::fill_n(neuronAccumulators.begin(), nnet.neurons.size(), 0.0f);
 
     // Connections were ordered at birth so that all connections to neurons get
     // processed here before any connections to actions. As soon as we encounter the
@@ -295,8 +278,8 @@ std::array<float, Actions::eType::NUM_ACTIONS> Peep::feedForward(
                 (Sensors::eType)conn.sourceNum,
                 simStep,
                 oldestAge,
-                m_Grid,
-                m_Params,
+                grid,
+                params,
                 random,
                 pheromoneSignals);
         } else {
@@ -6,17 +6,26 @@
 
 #include <array>
 #include <cstdint>
-#include <list>
-#include <map>
+#include <vector>
 
 class Grid;
 class Parameters;
 class RandomUintGenerator;
 
-class Peep 
+/*! \class Peep
+    \brief One individual of the population.
+
+    The peeps are stored as an array of these objects, ordered hot to cold. The fields
+    read and written every sim step by the actions and the challenge scans come first
+    and fill the first cache line of the aligned object, Peep.cpp checks that they fit.
+    The cold fields and the headers of the out-of-line genome and neural net follow.
+    A peep holds no references, the grid and the parameters are passed to the functions
+    that need them.
+*/
+class alignas(64) Peep
 {
 public:
-    Peep(const Parameters& params, const Grid& grid);
+    Peep() = default;
 
 
     /********************************************************************************
@@ -56,29 +65,32 @@ public:
         const PeepsPool& peeps,
         const PheromoneSignals& pheromoneSignals,
         const Sensors& sensors,
+        const Grid& grid,
+        const Parameters& params,
         RandomUintGenerator& random
     ); // reads sensors, returns actions
 
-    //! This is called when any individual is spawned.
-    //! The responsiveness parameter will be initialized here to maximum value
-    //! of 1.0, then depending on which action activation function is used,
-    //! the default undriven value may be changed to 1.0 or action midrange.
+    //! This is called when any individual is spawned. It takes the genome and builds
+    //! the neural net, relocate() places the peep afterwards. Touches nothing but the
+    //! peep, so different peeps may be spawned in parallel.
     void initialize(
-        uint16_t index_,
-        Coord loc_,
+        PeepIndex index_,
         Genetics::Genome &&genome_,
-        RandomUintGenerator& random,
         uint8_t sensorTypeCount,
         uint8_t actionTypeCount,
-        Grid& grid);
+        const Parameters& params);
 
-    //! Called only if surviveToNextGeneration is enabled. Relocate existing peep.
-    //! Some peeps should survive to the next round. Survival depends on their fittness,
-    //! If survivalByFitness is enabled, otherwise randomly selected.
+    //! Places the peep at the start of a generation, after initialize() for new peeps.
+    //! Some peeps survive to the next round and are only relocated. Survival depends on
+    //! their fittness, if survivalByFitness is enabled, otherwise randomly selected.
+    //! The responsiveness parameter will be initialized here to maximum value
+    //! of 1.0, then depending on which action activation function is used,
+    //! the default undriven value may be changed to 1.0 or action midrange.
     void relocate(
         Coord loc_,
         RandomUintGenerator& random,
-        Grid& grid);
+        Grid& grid,
+        const Parameters& params);
     
     //! This function is used when an agent is spawned. This function converts the
     //! agent's inherited genome into the agent's neural net brain. There is a close
@@ -90,7 +102,7 @@ public:
     //!    range 0..p.genomeMaxLength-1, keeping a count of outputs for each neuron.
     //! 2. Delete any referenced neuron index that has no outputs or only feeds itself.
     //! 3. Renumber the remaining neurons sequentially starting at 0.
-    void createWiringFromGenome(uint8_t sensorTypeCount, uint8_t actionTypeCount); // creates .nnet member from .genome member
+    void createWiringFromGenome(uint8_t sensorTypeCount, uint8_t actionTypeCount, const Parameters& params); // creates .nnet member from .genome member
     // void printNeuralNet() const;
     //! This prints a neural net in a form that can be processed with
     //! graph-nnet.py to produce a graphic illustration of the net.
@@ -98,23 +110,26 @@ public:
     //! Format: 32-bit hex strings, one per gene.
     void printGenome() const;
 
+    // Hot fields, used every sim step.
     bool alive{false};
     bool survivedToNextGen{false};  ///< Whether the peep has survived the generation and will respawn in the next.
-    uint16_t index;                 ///< index into PeepsPool[] container
-    Coord plannedLoc{};             ///< Stores the planned location the peep tries to get to, generated by PlanLocX and PlanLocY.
-    unsigned plannedSimStep{};      ///< Stores the planned sim step for the completion of a task.
-    unsigned planTimeUpdateStep{};  ///< Stores the time, when the plannedSimStep is updated.
+    Dir lastMoveDir;                ///< direction of last movement
+    PeepIndex index;                ///< index into PeepsPool[] container
     Coord loc{};                    ///< refers to a location in grid[][]
-    Coord birthLoc{};               ///< Location where the peep was created.
     unsigned age;
-
-    Genetics::Genome genome;        ///< Contains all the genes describing the neural network.
-    Genetics::NeuralNet nnet;       ///< derived from .genome
     float responsiveness;           ///< 0.0..1.0 (0 is like asleep)
     unsigned oscPeriod;             ///< 2..4*p.stepsPerGeneration (TBD, see executeActions())
     unsigned longProbeDist;         ///< distance for long forward probe for obstructions
-    Dir lastMoveDir;                ///< direction of last movement
     unsigned challengeBits;         ///< modified when the peep accomplishes some task
+    Coord plannedLoc{};             ///< Stores the planned location the peep tries to get to, generated by PlanLocX and PlanLocY.
+    unsigned plannedSimStep{};      ///< Stores the planned sim step for the completion of a task.
+    unsigned planTimeUpdateStep{};  ///< Stores the time, when the plannedSimStep is updated.
+
+    // Cold fields, the genes and connections are stored out-of-line.
+    Coord birthLoc{};               ///< Location where the peep was created.
+    Genetics::NeuralNet nnet;       ///< derived from .genome
+    Genetics::Genome genome;        ///< Contains all the genes describing the neural network.
+    Genetics::GenomeSketch sketch{}; ///< Sketch of .genome, see Sensors::PrepareGeneticSimilarity().
 private:
     //! This structure is used while converting the connection list to a
     //! neural net. This helps us to find neurons that don't feed anything
@@ -124,20 +139,26 @@ private:
     //! Finally, we'll renumber the remaining neurons sequentially starting
     //! at zero using the .remappedNumber member.
     struct Node {
+        bool used;                  ///< The neuron is mentioned by a connection and not culled.
         uint16_t remappedNumber;
         uint16_t numOutputs;
         uint16_t numSelfInputs;
         uint16_t numInputsFromSensorsOrOtherNeurons;
     };
 
+    //! The genes store neuron numbers in 7 bits, so a net never has more neurons.
+    static constexpr unsigned cMaxNeurons = 1u << 7;
+
     //! Two neuron renumberings occur: The original genome uses a uint16_t for
     //! neuron numbers. The first renumbering maps 16-bit unsigned neuron numbers
     //! to the range 0..p.maxNumberNeurons - 1. After culling useless neurons
     //! (see comments above), we'll renumber the remaining neurons sequentially
     //! starting at 0.
-    typedef std::map<uint16_t, Node> NodeMap; // key is neuron number 0..p.maxNumberNeurons - 1
+    typedef std::array<Node, cMaxNeurons> NodeMap; // index is neuron number 0..p.maxNumberNeurons - 1
 
-    typedef std::list<Genetics::Gene> ConnectionList;
+    //! The wiring is built in per-thread scratch containers that keep their capacity,
+    //! so a birth allocates nothing once the nets of the first generations were built.
+    typedef std::vector<Genetics::Gene> ConnectionList;
     //! Convert the indiv's genome to a renumbered connection list.
     //! This renumbers the neurons from their uint16_t values in the genome
     //! to the range 0..p.maxNumberNeurons - 1 by using a modulo operator.
@@ -147,24 +168,21 @@ private:
         ConnectionList &connectionList, 
         const Genetics::Genome &genome,
         uint8_t sensorTypeCount,
-        uint8_t actionTypeCount);
+        uint8_t actionTypeCount,
+        const Parameters& params);
 
     //! Scan the connections and make a list of all the neuron numbers
     //! mentioned in the connections. Also keep track of how many inputs and
     //! outputs each neuron has.
-    void makeNodeList(NodeMap &nodeMap, const ConnectionList &connectionList);
+    void makeNodeList(NodeMap &nodeMap, const ConnectionList &connectionList, const Parameters& params);
 
     // If a neuron has no outputs or only outputs that feed itself, then we
     // remove it along with all connections that feed it. Reiterative, because
     // after we remove a connection to a useless neuron, it may result in a
     // different neuron having no outputs.
-    void cullUselessNeurons(ConnectionList &connections, NodeMap &nodeMap);
+    void cullUselessNeurons(ConnectionList &connections, NodeMap &nodeMap, const Parameters& params);
 
     // During the culling process, we will remove any neuron that has no outputs,
     // and all the connections that feed the useless neuron.
     void removeConnectionsToNeuron(ConnectionList &connections, NodeMap &nodeMap, uint16_t neuronNumber);
-
-private:
-    const Parameters& m_Params;
-    const Grid& m_Grid;
 };
\ No newline at end of file
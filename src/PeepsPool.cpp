@@ -1,5 +1,8 @@
 #include "PeepsPool.h"
 
+#include <algorithm>
+#include <cassert>
+
 //-------------------------------------------------------------------------
 PeepsPool::PeepsPool(Grid& grid)
   : m_Grid(grid)
@@ -8,12 +11,33 @@ PeepsPool::PeepsPool(Grid& grid)
 }
 
 //-------------------------------------------------------------------------
-void PeepsPool::init(unsigned population, const Parameters& params)
+void PeepsPool::init(unsigned population)
 {
     // Index 0 is reserved, so add one:
-    for(unsigned i = 0; i < population + 1; ++i)
-    {
-        peeps.emplace_back(Peep(params, m_Grid));
+    peeps.resize(population + 1);
+    m_LivePeeps.clear();
+    m_LivePositions.assign(population + 1, 0);
+}
+
+//-------------------------------------------------------------------------
+void PeepsPool::rebuildLivePeeps()
+{
+    m_LivePeeps.clear();
+    for (PeepIndex index = 1; index < peeps.size(); ++index) {
+        if (peeps[index].alive) {
+            m_LivePositions[index] = m_LivePeeps.size();
+            m_LivePeeps.push_back(index);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void PeepsPool::reorderLivePeeps(std::vector<PeepIndex>& order)
+{
+    assert(order.size() == m_LivePeeps.size());
+    m_LivePeeps.swap(order);
+    for (size_t position = 0; position < m_LivePeeps.size(); ++position) {
+        m_LivePositions[m_LivePeeps[position]] = position;
     }
 }
 
@@ -30,10 +54,22 @@ void PeepsPool::queueForDeath(const Peep &peep)
 //-------------------------------------------------------------------------
 void PeepsPool::drainDeathQueue()
 {
-    for (uint16_t index : deathQueue) {
+    // The threads queue the deaths in any order, sorting them keeps the order
+    // of the living peeps reproducible.
+    std::sort(deathQueue.begin(), deathQueue.end());
+    for (PeepIndex index : deathQueue) {
         auto& peep = (*this)[index];
+        // A peep may be queued more than once.
+        if (!peep.alive) {
+            continue;
+        }
         m_Grid.set(peep.loc, 0);
         peep.alive = false;
+        const uint32_t position = m_LivePositions[index];
+        const PeepIndex last = m_LivePeeps.back();
+        m_LivePeeps[position] = last;
+        m_LivePositions[last] = position;
+        m_LivePeeps.pop_back();
     }
     deathQueue.clear();
 }
@@ -45,7 +81,8 @@ void PeepsPool::drainMoveQueue()
         auto& peep = (*this)[moveRecord.first];
         Coord newLoc = moveRecord.second;
         Dir moveDir = (newLoc - peep.loc).asDir();
-        if (m_Grid.isEmptyAt(newLoc)) {
+        // Peeps killed in this sim step must not come back to the grid.
+        if (peep.alive && m_Grid.isEmptyAt(newLoc)) {
             m_Grid.set(peep.loc, 0);
             m_Grid.set(newLoc, peep.index);
             peep.loc = newLoc;
@@ -60,7 +97,7 @@ void PeepsPool::queueForMove(const Peep &peep, Coord newLoc)
 {
     #pragma omp critical
     {
-        auto record = std::make_pair<uint16_t, Coord>(uint16_t(peep.index), Coord(newLoc));
+        auto record = std::make_pair<PeepIndex, Coord>(PeepIndex(peep.index), Coord(newLoc));
         moveQueue.push_back(record);
     }
 }
\ No newline at end of file
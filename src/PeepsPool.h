@@ -7,18 +7,16 @@
 #include <cstdint>
 #include <vector>
 
-class Parameters;
-
 // This class keeps track of alive and dead Indiv's and where they
 // are in the Grid.
 // Peeps allows spawning a live Indiv at a random or specific location
 // in the grid, moving Indiv's from one grid location to another, and
 // killing any Indiv.
 // All the Indiv instances, living and dead, are stored in the private
-// .peeps member. The .cull() function will remove dead members and
-// replace their slots in the .peeps container with living members
-// from the end of the container for compacting the container.
-// Each Indiv has an identifying index in the range 1..0xfffe that is
+// .peeps member. The indexes of the living ones are kept in a dense list,
+// a death replaces its entry with the last one, so the sim step and the
+// challenges never visit the dead slots.
+// Each Indiv has an identifying index in the range 1..max(PeepIndex) - 1 that is
 // stored in the Grid at the location where the Indiv resides, such that
 // a Grid element value n refers to .peeps[n]. Index value 0 is
 // reserved, i.e., .peeps[0] is not a valid individual.
@@ -28,7 +26,7 @@ class PeepsPool {
 public:
     PeepsPool(Grid& grid);
 
-    void init(unsigned population, const Parameters& params);
+    void init(unsigned population);
     //! Safe to call during multithread mode.
     //! Indiv will remain alive and in-world until end of sim step when
     //! drainDeathQueue() is called.
@@ -44,19 +42,29 @@ public:
     //! but this function can move an individual any arbitrary distance.
     void drainMoveQueue();
     unsigned deathQueueSize() const { return deathQueue.size(); }
+    //! Indexes of the living peeps in no particular order, see SpatialOrder.
+    const std::vector<PeepIndex>& livePeeps() const { return m_LivePeeps; }
+    //! Collects the living peeps in index order. Called in single-thread mode
+    //! after the peeps were placed or restored.
+    void rebuildLivePeeps();
+    //! Replaces the list of the living peeps by \a order, which must hold the same
+    //! indexes. The buffers are swapped, \a order receives the former list.
+    void reorderLivePeeps(std::vector<PeepIndex>& order);
     // getPeep() does no error checking -- check first that loc is occupied
     Peep& getPeep(Coord loc) { return peeps[m_Grid.at(loc)]; }
     const Peep& getPeep(Coord loc) const { return peeps[m_Grid.at(loc)]; }
     // Direct access:
-    Peep & operator[](uint16_t index) { return peeps[index]; }
-    Peep const & operator[](uint16_t index) const { return peeps[index]; }
+    Peep & operator[](PeepIndex index) { return peeps[index]; }
+    Peep const & operator[](PeepIndex index) const { return peeps[index]; }
     
     void displaySampleGenomes(unsigned count);
 
 private:
     std::vector<Peep> peeps; // Index value 0 is reserved
-    std::vector<uint16_t> deathQueue;
-    std::vector<std::pair<uint16_t, Coord>> moveQueue;
+    std::vector<PeepIndex> deathQueue;
+    std::vector<std::pair<PeepIndex, Coord>> moveQueue;
+    std::vector<PeepIndex> m_LivePeeps;
+    std::vector<uint32_t> m_LivePositions; // Position of each peep in m_LivePeeps, indexed like .peeps
 
     Grid& m_Grid;
 };
\ No newline at end of file
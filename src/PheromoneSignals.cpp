@@ -1,9 +1,9 @@
 #include "PheromoneSignals.h"
 
 #include "Parameters.h"
-#include "AlgorithmHelpers.h"
 
-#include "limits.h"
+#include <algorithm>
+#include <cmath>
 
 //-------------------------------------------------------------------------
 PheromoneSignals::PheromoneSignals(const Parameters& params)
@@ -15,22 +15,188 @@ PheromoneSignals::PheromoneSignals(const Parameters& params)
 //-------------------------------------------------------------------------
 void PheromoneSignals::init(uint16_t numLayers, uint16_t sizeX, uint16_t sizeY)
 {
-    data = std::vector<Layer>(numLayers, Layer(sizeX, sizeY));
+    m_Layers = numLayers;
+    m_SizeX = sizeX;
+    m_SizeY = sizeY;
+    m_Sparse = m_Params.sparseWorld;
+    m_DiffusionWeight = m_Sparse ? 0 : std::lround(std::clamp(m_Params.signalDiffusion, 0.0f, 1.0f) * 128);
+    m_Lazy = m_Params.lazySignalFade && !m_Sparse && m_DiffusionWeight == 0;
+    if (m_Sparse) {
+        m_Cells.clear();
+        m_Chunks = std::vector<ChunkedLayer<uint8_t>>(numLayers);
+        for (auto& layer : m_Chunks) {
+            layer.Init(sizeX, sizeY);
+        }
+    } else {
+        m_Cells.assign(size_t(numLayers) * sizeX * sizeY, 0);
+        m_Chunks.clear();
+    }
+    m_Scratch.assign(m_DiffusionWeight > 0 ? m_Cells.size() : 0, 0);
+    m_Stamps.assign(m_Lazy ? m_Cells.size() : 0, 0);
+    m_FadeCount = 0;
+}
+
+//-------------------------------------------------------------------------
+void PheromoneSignals::zeroFill()
+{
+    std::fill(m_Cells.begin(), m_Cells.end(), 0);
+    for (auto& layer : m_Chunks) {
+        layer.Clear();
+    }
+    // All values are zero, the stamps do not matter.
+    m_FadeCount = 0;
+}
+
+//-------------------------------------------------------------------------
+void PheromoneSignals::copyLayer(uint16_t layerNum, uint8_t* dest) const
+{
+    const size_t layerSize = size_t(m_SizeX) * m_SizeY;
+    if (m_Sparse) {
+        std::fill(dest, dest + layerSize, 0);
+        const unsigned chunkSize = ChunkedLayer<uint8_t>::cChunkSize;
+        m_Chunks[layerNum].ForEachResidentChunk([&](const ChunkedLayer<uint8_t>::Chunk& chunk, uint16_t originX, uint16_t originY) {
+            // Chunks on the far edges reach beyond the world.
+            const unsigned width = std::min<unsigned>(chunkSize, m_SizeX - originX);
+            const unsigned height = std::min<unsigned>(chunkSize, m_SizeY - originY);
+            for (unsigned x = 0; x < width; ++x) {
+                std::copy_n(&chunk.cells[x * chunkSize], height, &dest[size_t(originX + x) * m_SizeY + originY]);
+            }
+        });
+        return;
+    }
+
+    const size_t first = layerNum * layerSize;
+    if (m_Lazy) {
+        for (size_t index = 0; index < layerSize; ++index) {
+            dest[index] = faded(first + index, m_Cells[first + index]);
+        }
+        return;
+    }
+    std::copy_n(&m_Cells[first], layerSize, dest);
+}
+
+//-------------------------------------------------------------------------
+void PheromoneSignals::restoreLayer(uint16_t layerNum, const uint8_t* src)
+{
+    const size_t layerSize = size_t(m_SizeX) * m_SizeY;
+    if (m_Sparse) {
+        m_Chunks[layerNum].Clear();
+        for (uint16_t x = 0; x < m_SizeX; ++x) {
+            for (uint16_t y = 0; y < m_SizeY; ++y) {
+                m_Chunks[layerNum].Set(x, y, src[size_t(x) * m_SizeY + y]);
+            }
+        }
+        return;
+    }
+
+    const size_t first = layerNum * layerSize;
+    std::copy_n(src, layerSize, &m_Cells[first]);
+    if (m_Lazy) {
+        std::fill_n(&m_Stamps[first], layerSize, uint16_t(m_FadeCount));
+    }
+}
+
+//-------------------------------------------------------------------------
+void PheromoneSignals::setMagnitude(uint16_t layerNum, Coord loc, uint8_t val)
+{
+    if (m_Sparse) {
+        m_Chunks[layerNum].Set(loc.x, loc.y, val);
+        return;
+    }
+    size_t index = cellIndex(layerNum, loc);
+    m_Cells[index] = val;
+    if (m_Lazy) {
+        m_Stamps[index] = uint16_t(m_FadeCount);
+    }
 }
 
 //-------------------------------------------------------------------------
-void PheromoneSignals::fade(unsigned layerNum)
+void PheromoneSignals::update()
 {
-    constexpr unsigned fadeAmount = 1;
-
-    for (int16_t x = 0; x < m_Params.sizeX; ++x) {
-        for (int16_t y = 0; y < m_Params.sizeY; ++y) {
-            if ((*this)[layerNum][x][y] >= fadeAmount) {
-                (*this)[layerNum][x][y] -= fadeAmount;  // fade center cell
-            } else {
-                (*this)[layerNum][x][y] = 0;
+    if (m_Lazy) {
+        // The stamps are compared modulo 2^16. Writing back the faded values every 2^15
+        // fades keeps the age of every cell below 2^16.
+        if (++m_FadeCount % 0x8000 == 0) {
+#pragma omp parallel for simd num_threads(m_Params.numThreads) schedule(static)
+            for (size_t index = 0; index < m_Cells.size(); ++index) {
+                m_Cells[index] = faded(index, m_Cells[index]);
+                m_Stamps[index] = uint16_t(m_FadeCount);
             }
         }
+        return;
+    }
+
+    if (m_Sparse) {
+        for (auto& layer : m_Chunks) {
+            layer.ForEachResidentChunk([](ChunkedLayer<uint8_t>::Chunk& chunk, uint16_t, uint16_t) {
+                unsigned nonZeroCount = 0;
+                for (uint8_t& cell : chunk.cells) {
+                    unsigned val = cell;
+                    cell = val > cFadeAmount ? val - cFadeAmount : 0;
+                    nonZeroCount += cell != 0;
+                }
+                chunk.nonZeroCount = nonZeroCount;
+            });
+            layer.ReleaseEmptyChunks();
+        }
+        return;
+    }
+
+    if (m_DiffusionWeight > 0) {
+        diffuseAndFade();
+        return;
+    }
+
+    // Saturating subtract over all layers at once. GCC only vectorizes it when
+    // written as a compare and select, not with std::max.
+    uint8_t* cells = m_Cells.data();
+    const int64_t count = m_Cells.size();
+#pragma omp parallel for simd num_threads(m_Params.numThreads) schedule(static)
+    for (int64_t index = 0; index < count; ++index) {
+        unsigned val = cells[index];
+        cells[index] = val > cFadeAmount ? val - cFadeAmount : 0;
+    }
+}
+
+//-------------------------------------------------------------------------
+void PheromoneSignals::diffuseAndFade()
+{
+    // Each pass spreads m_DiffusionWeight / 256 of a cell to each of its two neighbors
+    // along one axis. The weights sum up to 256, so the result stays in 0..SIGNAL_MAX.
+    // A neighbor outside of the world is replaced by the cell itself, no signal leaves.
+    // The weighted sums are below 2^16, so the vector loops work on 16-bit lanes.
+    const uint16_t side = m_DiffusionWeight;
+    const uint16_t center = 256 - 2 * side;
+    const int sizeX = m_SizeX;
+    const int sizeY = m_SizeY;
+    const int columns = m_Layers * sizeX;
+
+    // Along y, within each column.
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(static)
+    for (int column = 0; column < columns; ++column) {
+        const uint8_t* in = &m_Cells[size_t(column) * sizeY];
+        uint8_t* out = &m_Scratch[size_t(column) * sizeY];
+        out[0] = (in[0] * (center + side) + in[1] * side + 128) >> 8;
+#pragma omp simd
+        for (int y = 1; y < sizeY - 1; ++y) {
+            out[y] = uint16_t(in[y] * center + (in[y - 1] + in[y + 1]) * side + 128) >> 8;
+        }
+        out[sizeY - 1] = (in[sizeY - 1] * (center + side) + in[sizeY - 2] * side + 128) >> 8;
+    }
+
+    // Along x, from the neighbor columns of the same layer, then the fade.
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(static)
+    for (int column = 0; column < columns; ++column) {
+        const int x = column % sizeX;
+        const uint8_t* mid = &m_Scratch[size_t(column) * sizeY];
+        const uint8_t* left = x > 0 ? mid - sizeY : mid;
+        const uint8_t* right = x < sizeX - 1 ? mid + sizeY : mid;
+        uint8_t* out = &m_Cells[size_t(column) * sizeY];
+#pragma omp simd
+        for (int y = 0; y < sizeY; ++y) {
+            uint16_t val = uint16_t(mid[y] * center + (left[y] + right[y]) * side + 128) >> 8;
+            out[y] = val > cFadeAmount ? val - cFadeAmount : 0;
+        }
     }
 }
 
@@ -42,24 +208,28 @@ void PheromoneSignals::fade(unsigned layerNum)
 //-------------------------------------------------------------------------
 void PheromoneSignals::increment(uint16_t layerNum, Coord loc)
 {
-    constexpr float radius = 1.5;
     constexpr uint8_t centerIncreaseAmount = 2;
     constexpr uint8_t neighborIncreaseAmount = 1;
 
+    auto add = [layerNum, this](Coord loc, unsigned amount) {
+        unsigned val = getMagnitude(layerNum, loc);
+        if (val < SIGNAL_MAX) {
+            setMagnitude(layerNum, loc, std::min<unsigned>(SIGNAL_MAX, val + amount));
+        }
+    };
+
 #pragma omp critical
     {
-        AlgorithmHelpers::visitNeighborhood(loc, radius, [layerNum, this](Coord loc) {
-            if ((*this)[layerNum][loc.x][loc.y] < SIGNAL_MAX) {
-                (*this)[layerNum][loc.x][loc.y] =
-                        std::min<unsigned>(SIGNAL_MAX,
-                                           (*this)[layerNum][loc.x][loc.y] + neighborIncreaseAmount);
+        // The neighborhood of radius 1.5 is the 3x3 block around loc, clipped to the world.
+        const int16_t x0 = std::max(0, loc.x - 1);
+        const int16_t x1 = std::min(m_SizeX - 1, loc.x + 1);
+        const int16_t y0 = std::max(0, loc.y - 1);
+        const int16_t y1 = std::min(m_SizeY - 1, loc.y + 1);
+        for (int16_t x = x0; x <= x1; ++x) {
+            for (int16_t y = y0; y <= y1; ++y) {
+                add(Coord(x, y), neighborIncreaseAmount);
             }
-        }, m_Params);
-
-        if ((*this)[layerNum][loc.x][loc.y] < SIGNAL_MAX) {
-            (*this)[layerNum][loc.x][loc.y] =
-                        std::min<unsigned>(SIGNAL_MAX,
-                                           (*this)[layerNum][loc.x][loc.y] + centerIncreaseAmount);
         }
+        add(loc, centerIncreaseAmount);
     }
-}
\ No newline at end of file
+}
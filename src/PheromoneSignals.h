@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BasicTypes.h"
+#include "ChunkedLayer.h"
 
 #include <cstdint>
 #include <vector>
@@ -9,44 +10,73 @@ class Parameters;
 
 constexpr unsigned SIGNAL_MIN = 0;
 constexpr unsigned SIGNAL_MAX = UINT8_MAX;
+constexpr unsigned SIGNAL_LAYERS_MAX = 4;  ///< One SIGNALn sensor trio and EMIT_SIGNALn action per layer.
 
-struct PheromoneSignals 
+// PheromoneSignals holds Parameters::signalLayers layers of uint8_t magnitudes.
+// In dense mode all layers live in one contiguous buffer, layer after layer, each
+// layer column major like the grid. The per step update() then runs over the
+// buffer with loops the compiler turns into saturating byte arithmetic.
+// If Parameters::sparseWorld is set, every layer is stored in 64x64 chunks
+// allocated on first write instead, see ChunkedLayer.
+struct PheromoneSignals
 {
     PheromoneSignals(const Parameters& params);
 
-    struct Column {
-        Column(uint16_t numRows) : data { std::vector<uint8_t>(numRows, 0) } { }
-        uint8_t& operator[](uint16_t rowNum) { return data[rowNum]; }
-        uint8_t operator[](uint16_t rowNum) const { return data[rowNum]; }
-        void zeroFill() { std::fill(data.begin(), data.end(), 0); }
-    private:
-        std::vector<uint8_t> data;
-    };
-
-    struct Layer {
-        Layer(uint16_t numCols, uint16_t numRows) : data { std::vector<Column>(numCols, Column(numRows)) } { }
-        Column& operator[](uint16_t colNum) { return data[colNum]; }
-        const Column& operator[](uint16_t colNum) const { return data[colNum]; }
-        void zeroFill() { for (Column &col : data) { col.zeroFill(); } }
-    private:
-        std::vector<Column> data;
-    };
-
+    //! Allocates the layers, chunked if Parameters::sparseWorld is set.
     void init(uint16_t layers, uint16_t sizeX, uint16_t sizeY);
-    Layer& operator[](uint16_t layerNum) { return data[layerNum]; }
-    const Layer& operator[](uint16_t layerNum) const { return data[layerNum]; }
-    uint8_t getMagnitude(uint16_t layerNum, Coord loc) const { return (*this)[layerNum][loc.x][loc.y]; }
+    uint16_t layerCount() const { return m_Layers; }
+    uint8_t getMagnitude(uint16_t layerNum, Coord loc) const
+    {
+        if (m_Sparse) {
+            return m_Chunks[layerNum].Get(loc.x, loc.y);
+        }
+        size_t index = cellIndex(layerNum, loc);
+        return m_Lazy ? faded(index, m_Cells[index]) : m_Cells[index];
+    }
     //! Increases the specified location by centerIncreaseAmount,
     //! and increases the neighboring cells by neighborIncreaseAmount
 
     //! Is it ok that multiple readers are reading this container while
     //! this single thread is writing to it?  todo!!!
     void increment(uint16_t layerNum, Coord loc);
-    void zeroFill() { for (Layer &layer : data) { layer.zeroFill(); } }
-    //! Fades the signals.
-    void fade(unsigned layerNum);
+    void zeroFill();
+    //! Copies the magnitudes of a layer to \a dest, sizeX * sizeY bytes laid out
+    //! column major like the dense storage. A single memcpy unless the layer is
+    //! sparse or lazily faded. Must not run concurrently with the sim step.
+    void copyLayer(uint16_t layerNum, uint8_t* dest) const;
+    //! Counterpart of copyLayer(), used to restore a checkpoint.
+    void restoreLayer(uint16_t layerNum, const uint8_t* src);
+    //! Fades every layer by one step and, if Parameters::signalDiffusion is set,
+    //! diffuses them. Called once per sim step in single-thread mode.
+    //! In sparse mode only the resident chunks are faded, the ones faded to zero
+    //! are freed. In lazy fade mode only the fade count is increased.
+    void update();
 private:
-    std::vector<Layer> data;
+    static constexpr unsigned cFadeAmount = 1;  ///< Subtracted from every cell by update().
+
+    size_t cellIndex(uint16_t layerNum, Coord loc) const { return (size_t(layerNum) * m_SizeX + loc.x) * m_SizeY + loc.y; }
+    void setMagnitude(uint16_t layerNum, Coord loc, uint8_t val);
+    //! Lazy fade mode: applies the fades since the last write of the cell to \a val.
+    uint8_t faded(size_t index, uint8_t val) const
+    {
+        unsigned age = uint16_t(m_FadeCount - m_Stamps[index]);
+        return age * cFadeAmount < val ? val - age * cFadeAmount : 0;
+    }
+    //! Dense mode: the separable diffusion stencil followed by the fade.
+    void diffuseAndFade();
+
+    uint16_t m_Layers{};
+    uint16_t m_SizeX{};
+    uint16_t m_SizeY{};
+    std::vector<uint8_t> m_Cells{};                 ///< Storage in dense mode, [layer][x][y].
+    std::vector<uint8_t> m_Scratch{};               ///< Output of the first diffusion pass.
+    std::vector<ChunkedLayer<uint8_t>> m_Chunks{};  ///< Storage in sparse mode, m_Cells is empty then.
+    bool m_Sparse{false};
+    bool m_Lazy{false};                             ///< Parameters::lazySignalFade in dense mode without diffusion.
+    unsigned m_DiffusionWeight{};                   ///< Neighbor weight of the diffusion stencil in 1/256.
+    std::vector<uint16_t> m_Stamps{};               ///< Lazy fade mode: fade count at the last write of each cell,
+                                                    ///< same layout as m_Cells. Compared modulo 2^16.
+    unsigned m_FadeCount{};                         ///< Lazy fade mode: fades since zeroFill().
 
     const Parameters& m_Params;
-};
\ No newline at end of file
+};
@@ -0,0 +1,625 @@
+#include "Phylogeny.h"
+
+#include "Parameters.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <set>
+
+#include <fcntl.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr const char* cColumnFiles[] = {
+        "generation.col", "parents.col", "mutations.col", "genes.idx", "children.col", "siblings.col", "genes.dat"};
+    constexpr size_t cColumnRowSizes[] = {
+        sizeof(uint32_t), 2 * sizeof(uint64_t), sizeof(Phylogeny::MutationRecord), sizeof(uint64_t), sizeof(uint64_t), 2 * sizeof(uint64_t), 1};
+    constexpr size_t cChildrenColumn = 4;
+    constexpr size_t cSiblingsColumn = 5;
+    constexpr size_t cDataColumn = 6;     ///< The only column without fixed size rows, kept last.
+
+    static_assert(sizeof(Phylogeny::MutationRecord) == 8, "The mutation records are part of the file format");
+    static_assert(sizeof(Genetics::Gene) == 4, "The genes are part of the file format");
+
+    std::string storeDirectory(const Parameters& params)
+    {
+        return params.logDir + "/phylogeny";
+    }
+
+    bool sameGene(const Genetics::Gene& gene1, const Genetics::Gene& gene2)
+    {
+        return std::memcmp(&gene1, &gene2, sizeof(Genetics::Gene)) == 0;
+    }
+}
+
+//-------------------------------------------------------------------------
+PhylogenyRecorder::PhylogenyRecorder(const Parameters& params)
+    : m_Params(params)
+{
+    m_Writer = std::thread(&PhylogenyRecorder::WriterLoop, this);
+}
+
+//-------------------------------------------------------------------------
+PhylogenyRecorder::~PhylogenyRecorder()
+{
+    QueuePending();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wakeup.notify_one();
+    m_Writer.join();
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::BeginSpawn(unsigned generation, const std::vector<std::pair<PeepIndex, float>>& parents)
+{
+    if (!m_Params.savePhylogeny) {
+        return;
+    }
+    if (m_Ids.size() != m_Params.population + 1) {
+        m_Ids.assign(m_Params.population + 1, 0);
+        m_Chains.assign(m_Params.population + 1, cMaxChain);
+        m_YoungestChildren.assign(m_Params.population + 1, 0);
+    }
+    m_Spawning = true;
+    m_Generation = generation;
+    m_ParentIds.resize(parents.size());
+    m_ParentChains.resize(parents.size());
+    m_ParentIndexes.resize(parents.size());
+    m_ParentYoungestChildren.resize(parents.size());
+    for (size_t n = 0; n < parents.size(); ++n) {
+        m_ParentIds[n] = m_Ids[parents[n].first];
+        m_ParentChains[n] = m_Chains[parents[n].first];
+        m_ParentIndexes[n] = parents[n].first;
+        m_ParentYoungestChildren[n] = m_YoungestChildren[parents[n].first];
+    }
+    m_ThreadBuffers.resize(std::max<size_t>(omp_get_max_threads(), m_Params.numThreads));
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::AddBirth(
+    PeepIndex index,
+    unsigned primaryParent,
+    unsigned secondaryParent,
+    const Genetics::Genome& genome,
+    const Genetics::Genome* pPrimaryGenome)
+{
+    if (!m_Spawning) {
+        return;
+    }
+    ThreadBuffer& buffer = m_ThreadBuffers[omp_get_thread_num()];
+    Birth birth{index, primaryParent, secondaryParent, {}, buffer.data.size(), 0};
+    Phylogeny::MutationRecord& mutations = birth.mutations;
+    mutations.genomeLength = genome.size();
+    bool keyframe = true;
+
+    if (primaryParent != Phylogeny::cNoParent && pPrimaryGenome) {
+        // Deletions and front crops remove genes, insertions append them. The removal is
+        // placed behind the common prefix, the remaining differences are changed genes.
+        const Genetics::Genome& parent = *pPrimaryGenome;
+        const size_t removed = parent.size() > genome.size() ? parent.size() - genome.size() : 0;
+        size_t removedAt = 0;
+        while (removedAt < genome.size() && removedAt < parent.size() && sameGene(genome[removedAt], parent[removedAt])) {
+            ++removedAt;
+        }
+        const size_t baseLength = parent.size() - removed;
+        const size_t positionsOffset = buffer.data.size();
+        for (size_t n = removedAt; n < genome.size(); ++n) {
+            if (n >= baseLength || !sameGene(genome[n], parent[n + removed])) {
+                const uint16_t position = n;
+                const auto* pBytes = reinterpret_cast<const uint8_t*>(&position);
+                buffer.data.insert(buffer.data.end(), pBytes, pBytes + sizeof(position));
+            }
+        }
+        mutations.changedGenes = (buffer.data.size() - positionsOffset) / sizeof(uint16_t);
+        mutations.removedGenes = removed;
+        mutations.removedAt = removed > 0 ? removedAt : 0;
+        keyframe = m_ParentChains[primaryParent] >= cMaxChain
+            || mutations.changedGenes * (sizeof(uint16_t) + sizeof(Genetics::Gene)) >= genome.size() * sizeof(Genetics::Gene);
+        if (keyframe) {
+            buffer.data.resize(positionsOffset);
+        } else {
+            for (size_t n = 0; n < mutations.changedGenes; ++n) {
+                uint16_t position;
+                std::memcpy(&position, &buffer.data[positionsOffset + n * sizeof(position)], sizeof(position));
+                const auto* pBytes = reinterpret_cast<const uint8_t*>(&genome[position]);
+                buffer.data.insert(buffer.data.end(), pBytes, pBytes + sizeof(Genetics::Gene));
+            }
+        }
+    }
+    if (keyframe) {
+        // The changed and removed genes of a child still summarize its mutations.
+        mutations.removedAt = Phylogeny::cKeyframe;
+        const auto* pBytes = reinterpret_cast<const uint8_t*>(genome.data());
+        buffer.data.insert(buffer.data.end(), pBytes, pBytes + genome.size() * sizeof(Genetics::Gene));
+    }
+    birth.dataSize = buffer.data.size() - birth.dataOffset;
+    buffer.births.push_back(birth);
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::EndSpawn()
+{
+    if (!m_Spawning) {
+        return;
+    }
+    m_Spawning = false;
+
+    // Number the births in peep index order, independent of the thread that recorded them.
+    std::vector<std::pair<const Birth*, const ThreadBuffer*>> births;
+    for (const ThreadBuffer& buffer : m_ThreadBuffers) {
+        for (const Birth& birth : buffer.births) {
+            births.emplace_back(&birth, &buffer);
+        }
+    }
+    std::sort(births.begin(), births.end(),
+        [](const std::pair<const Birth*, const ThreadBuffer*>& birth1, const std::pair<const Birth*, const ThreadBuffer*>& birth2) {
+            return birth1.first->index < birth2.first->index;
+        });
+
+    auto pBatch = std::make_unique<Batch>();
+    pBatch->generations.reserve(births.size());
+    pBatch->parents.reserve(2 * births.size());
+    pBatch->mutations.reserve(births.size());
+    pBatch->dataOffsets.reserve(births.size());
+    pBatch->siblings.reserve(2 * births.size());
+    // Links the child into the sibling list of a parent, returns the next older sibling.
+    auto linkChild = [this](unsigned parent, uint64_t parentId, uint64_t id) -> uint64_t {
+        if (parentId == 0) {
+            return 0;
+        }
+        return std::exchange(m_ParentYoungestChildren[parent], id);
+    };
+    for (const auto& [pBirth, pBuffer] : births) {
+        const Birth& birth = *pBirth;
+        const bool keyframe = birth.mutations.removedAt == Phylogeny::cKeyframe;
+        const uint64_t id = m_NextId++;
+        const uint64_t primaryId = birth.primaryParent == Phylogeny::cNoParent ? 0 : m_ParentIds[birth.primaryParent];
+        const uint64_t secondaryId = birth.secondaryParent == Phylogeny::cNoParent ? 0 : m_ParentIds[birth.secondaryParent];
+        m_Ids[birth.index] = id;
+        m_Chains[birth.index] = keyframe ? 0 : m_ParentChains[birth.primaryParent] + 1;
+        pBatch->generations.push_back(m_Generation);
+        pBatch->parents.push_back(primaryId);
+        pBatch->parents.push_back(secondaryId);
+        // A child of a single parent is only listed once.
+        pBatch->siblings.push_back(linkChild(birth.primaryParent, primaryId, id));
+        pBatch->siblings.push_back(secondaryId != primaryId ? linkChild(birth.secondaryParent, secondaryId, id) : 0);
+        pBatch->mutations.push_back(birth.mutations);
+        pBatch->dataOffsets.push_back(m_DataSize + pBatch->data.size());
+        pBatch->data.insert(pBatch->data.end(), pBuffer->data.begin() + birth.dataOffset,
+                            pBuffer->data.begin() + birth.dataOffset + birth.dataSize);
+    }
+    m_DataSize += pBatch->data.size();
+    // The surviving parents keep their youngest child, the new lineages start without any.
+    for (size_t n = 0; n < m_ParentIds.size(); ++n) {
+        uint64_t& youngestChild = m_YoungestChildren[m_ParentIndexes[n]];
+        if (m_ParentIds[n] != 0 && m_ParentYoungestChildren[n] != youngestChild) {
+            pBatch->youngestChildren.emplace_back(m_ParentIds[n], m_ParentYoungestChildren[n]);
+        }
+        youngestChild = m_ParentYoungestChildren[n];
+    }
+    for (const auto& birth : births) {
+        m_YoungestChildren[birth.first->index] = 0;
+    }
+    for (ThreadBuffer& buffer : m_ThreadBuffers) {
+        buffer.births.clear();
+        buffer.data.clear();
+    }
+
+    QueuePending();
+    m_xPending = std::move(pBatch);
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::QueuePending()
+{
+    if (!m_xPending) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Written.wait(lock, [this]() { return m_Queue.size() < cMaxQueuedBatches; });
+        m_Queue.push_back(std::move(m_xPending));
+    }
+    m_Wakeup.notify_one();
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::Flush()
+{
+    QueuePending();
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Written.wait(lock, [this]() { return m_Queue.empty() && !m_Writing; });
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::Resume(uint64_t nextId, const std::vector<uint64_t>& ids)
+{
+    if (!m_Params.savePhylogeny) {
+        return;
+    }
+    // The births of the generation 0 spawned before the restore are not part of the run.
+    m_xPending.reset();
+    Flush();
+
+    // The writer is idle and has closed the files.
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_YoungestChildren.assign(m_Params.population + 1, 0);
+    bool resumed = nextId > 0 && ids.size() == m_Params.population + 1 && TruncateStore(nextId - 1);
+    if (resumed) {
+        // The youngest children of the living lineages are continued from the store.
+        std::ifstream children(storeDirectory(m_Params) + "/" + cColumnFiles[cChildrenColumn], std::ios::binary);
+        for (size_t index = 1; resumed && index < ids.size(); ++index) {
+            if (ids[index] > 0 && ids[index] < nextId) {
+                children.seekg((ids[index] - 1) * sizeof(uint64_t));
+                children.read(reinterpret_cast<char*>(&m_YoungestChildren[index]), sizeof(uint64_t));
+                resumed = bool(children);
+            }
+        }
+    }
+    if (resumed) {
+        m_Ids = ids;
+        m_NextId = nextId;
+    } else {
+        std::cout << "The phylogeny store lacks the births of the checkpoint, restarting the lineages." << std::endl;
+        TruncateStore(0);
+        m_Ids.assign(m_Params.population + 1, 0);
+        m_YoungestChildren.assign(m_Params.population + 1, 0);
+        m_NextId = 1;
+    }
+    m_Chains.assign(m_Params.population + 1, cMaxChain);
+    m_Truncate = false;
+}
+
+//-------------------------------------------------------------------------
+bool PhylogenyRecorder::TruncateStore(uint64_t count)
+{
+    const std::string directory = storeDirectory(m_Params);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    uint64_t sizes[std::size(cColumnFiles)];
+    for (size_t column = 0; column < std::size(cColumnFiles); ++column) {
+        const std::string path = directory + "/" + cColumnFiles[column];
+        sizes[column] = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    }
+
+    uint64_t dataSize = 0;
+    if (count > 0) {
+        for (size_t column = 0; column + 1 < std::size(cColumnFiles); ++column) {
+            if (sizes[column] / cColumnRowSizes[column] < count) {
+                return false;
+            }
+        }
+        dataSize = sizes[cDataColumn];
+        if (sizes[3] / sizeof(uint64_t) > count) {
+            std::ifstream offsets(directory + "/" + cColumnFiles[3], std::ios::binary);
+            offsets.seekg(count * sizeof(uint64_t));
+            offsets.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
+            if (!offsets || dataSize > sizes[cDataColumn]) {
+                return false;
+            }
+        }
+
+        // The kept births must not name a dropped one as their youngest child. Walking the
+        // dropped births from the youngest, each link steps back to the next older sibling.
+        const uint64_t rows = std::min(sizes[1] / cColumnRowSizes[1], sizes[cSiblingsColumn] / cColumnRowSizes[cSiblingsColumn]);
+        if (rows > count) {
+            std::ifstream parents(directory + "/" + cColumnFiles[1], std::ios::binary);
+            std::ifstream siblings(directory + "/" + cColumnFiles[cSiblingsColumn], std::ios::binary);
+            std::fstream children(directory + "/" + cColumnFiles[cChildrenColumn], std::ios::binary | std::ios::in | std::ios::out);
+            for (uint64_t child = rows; child > count; --child) {
+                uint64_t parentIds[2];
+                uint64_t links[2];
+                parents.seekg((child - 1) * sizeof(parentIds));
+                parents.read(reinterpret_cast<char*>(parentIds), sizeof(parentIds));
+                siblings.seekg((child - 1) * sizeof(links));
+                siblings.read(reinterpret_cast<char*>(links), sizeof(links));
+                for (unsigned parent = 0; parent < 2; ++parent) {
+                    const uint64_t parentId = parentIds[parent];
+                    if (parentId == 0 || parentId > count || (parent == 1 && parentId == parentIds[0])) {
+                        continue;
+                    }
+                    uint64_t youngestChild = 0;
+                    children.seekg((parentId - 1) * sizeof(youngestChild));
+                    children.read(reinterpret_cast<char*>(&youngestChild), sizeof(youngestChild));
+                    if (youngestChild == child) {
+                        children.seekp((parentId - 1) * sizeof(youngestChild));
+                        children.write(reinterpret_cast<const char*>(&links[parent]), sizeof(links[parent]));
+                    }
+                }
+            }
+            if (!parents || !siblings || !children) {
+                return false;
+            }
+        }
+    }
+
+    for (size_t column = 0; column < std::size(cColumnFiles); ++column) {
+        const std::string path = directory + "/" + cColumnFiles[column];
+        std::ofstream(path, std::ios::binary | std::ios::app).close();
+        std::filesystem::resize_file(path, column != cDataColumn ? count * cColumnRowSizes[column] : dataSize, error);
+        if (error) {
+            std::cerr << "Couldn't truncate " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+    m_DataSize = dataSize;
+    return true;
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_Wakeup.wait(lock, [this]() { return m_Stop || !m_Queue.empty(); });
+        if (m_Queue.empty()) {
+            break;
+        }
+        std::unique_ptr<Batch> pBatch = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        m_Writing = true;
+        const bool truncate = std::exchange(m_Truncate, false);
+        lock.unlock();
+
+        if (truncate) {
+            std::error_code error;
+            std::filesystem::remove_all(storeDirectory(m_Params), error);
+        }
+        Write(*pBatch);
+        pBatch.reset();
+
+        lock.lock();
+        m_Writing = false;
+        m_Written.notify_all();
+    }
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyRecorder::Write(const Batch& batch)
+{
+    const std::string directory = storeDirectory(m_Params);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    auto append = [&directory](const char* pName, const auto& values) {
+        const std::string path = directory + "/" + pName;
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+        if (!file) {
+            std::cerr << "Couldn't write " << path << "." << std::endl;
+        }
+    };
+    // The files are closed after each batch, Resume() truncates them while the writer waits.
+    append(cColumnFiles[0], batch.generations);
+    append(cColumnFiles[1], batch.parents);
+    append(cColumnFiles[2], batch.mutations);
+    append(cColumnFiles[3], batch.dataOffsets);
+    append(cColumnFiles[cChildrenColumn], std::vector<uint64_t>(batch.generations.size(), 0));
+    append(cColumnFiles[cSiblingsColumn], batch.siblings);
+    append(cColumnFiles[cDataColumn], batch.data);
+
+    // The parents of the batch are older than its births, their rows are in place.
+    const std::string path = directory + "/" + cColumnFiles[cChildrenColumn];
+    std::fstream children(path, std::ios::binary | std::ios::in | std::ios::out);
+    for (const auto& [parentId, youngestChild] : batch.youngestChildren) {
+        children.seekp((parentId - 1) * sizeof(youngestChild));
+        children.write(reinterpret_cast<const char*>(&youngestChild), sizeof(youngestChild));
+    }
+    if (!children) {
+        std::cerr << "Couldn't write " << path << "." << std::endl;
+    }
+}
+
+//-------------------------------------------------------------------------
+PhylogenyReader::~PhylogenyReader()
+{
+    Close();
+}
+
+//-------------------------------------------------------------------------
+void PhylogenyReader::Close()
+{
+    for (Mapping& mapping : m_Mappings) {
+        if (mapping.pData) {
+            munmap(mapping.pData, mapping.size);
+        }
+        mapping = Mapping();
+    }
+    m_Count = 0;
+    m_pGenerations = nullptr;
+    m_pParents = nullptr;
+    m_pMutations = nullptr;
+    m_pDataOffsets = nullptr;
+    m_pChildren = nullptr;
+    m_pSiblings = nullptr;
+    m_pData = nullptr;
+}
+
+//-------------------------------------------------------------------------
+bool PhylogenyReader::Open(const std::string& directory)
+{
+    Close();
+    for (unsigned column = 0; column < ColumnCount; ++column) {
+        const std::string path = directory + "/" + cColumnFiles[column];
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (fd < 0 || fstat(fd, &status) != 0) {
+            std::cerr << "Couldn't open " << path << "." << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            Close();
+            return false;
+        }
+        m_Mappings[column].size = status.st_size;
+        if (status.st_size > 0) {
+            void* pData = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            m_Mappings[column].pData = pData == MAP_FAILED ? nullptr : pData;
+        }
+        close(fd);
+        if (status.st_size > 0 && !m_Mappings[column].pData) {
+            std::cerr << "Couldn't map " << path << "." << std::endl;
+            Close();
+            return false;
+        }
+    }
+
+    const uint64_t count = m_Mappings[Generations].size / sizeof(uint32_t);
+    bool valid = true;
+    for (unsigned column = 0; valid && column < Data; ++column) {
+        valid = m_Mappings[column].size == count * cColumnRowSizes[column];
+    }
+    if (!valid) {
+        std::cerr << "Inconsistent phylogeny store " << directory << "." << std::endl;
+        Close();
+        return false;
+    }
+    m_Count = count;
+    m_pGenerations = static_cast<const uint32_t*>(m_Mappings[Generations].pData);
+    m_pParents = static_cast<const uint64_t*>(m_Mappings[Parents].pData);
+    m_pMutations = static_cast<const Phylogeny::MutationRecord*>(m_Mappings[Mutations].pData);
+    m_pDataOffsets = static_cast<const uint64_t*>(m_Mappings[DataOffsets].pData);
+    m_pChildren = static_cast<const uint64_t*>(m_Mappings[Children].pData);
+    m_pSiblings = static_cast<const uint64_t*>(m_Mappings[Siblings].pData);
+    m_pData = static_cast<const uint8_t*>(m_Mappings[Data].pData);
+    return true;
+}
+
+//-------------------------------------------------------------------------
+PhylogenyReader::Record PhylogenyReader::Get(uint64_t id) const
+{
+    const uint64_t row = id - 1;
+    return {m_pGenerations[row], m_pParents[2 * row], m_pParents[2 * row + 1], m_pMutations[row]};
+}
+
+//-------------------------------------------------------------------------
+Genetics::Genome PhylogenyReader::GetGenome(uint64_t id) const
+{
+    // Collect the primary line back to the last keyframe, then apply the deltas forwards.
+    std::vector<uint64_t> line;
+    for (uint64_t ancestor = id; ; ancestor = m_pParents[2 * (ancestor - 1)]) {
+        if (ancestor == 0 || ancestor > m_Count) {
+            return {};
+        }
+        line.push_back(ancestor);
+        if (m_pMutations[ancestor - 1].removedAt == Phylogeny::cKeyframe) {
+            break;
+        }
+    }
+
+    Genetics::Genome genome;
+    for (auto it = line.rbegin(); it != line.rend(); ++it) {
+        const Phylogeny::MutationRecord& mutations = m_pMutations[*it - 1];
+        const uint64_t offset = m_pDataOffsets[*it - 1];
+        const bool keyframe = mutations.removedAt == Phylogeny::cKeyframe;
+        const uint64_t size = keyframe ? mutations.genomeLength * sizeof(Genetics::Gene)
+                                       : mutations.changedGenes * (sizeof(uint16_t) + sizeof(Genetics::Gene));
+        if (offset > m_Mappings[Data].size || size > m_Mappings[Data].size - offset) {
+            return {};
+        }
+        const uint8_t* pDelta = m_pData + offset;
+        if (keyframe) {
+            genome.resize(mutations.genomeLength);
+            std::memcpy(genome.data(), pDelta, size);
+            continue;
+        }
+        if (size_t(mutations.removedAt) + mutations.removedGenes > genome.size()) {
+            return {};
+        }
+        genome.erase(genome.begin() + mutations.removedAt, genome.begin() + mutations.removedAt + mutations.removedGenes);
+        genome.resize(mutations.genomeLength);
+        const uint8_t* pGenes = pDelta + mutations.changedGenes * sizeof(uint16_t);
+        for (unsigned n = 0; n < mutations.changedGenes; ++n) {
+            uint16_t position;
+            std::memcpy(&position, pDelta + n * sizeof(position), sizeof(position));
+            if (position >= genome.size()) {
+                return {};
+            }
+            std::memcpy(&genome[position], pGenes + n * sizeof(Genetics::Gene), sizeof(Genetics::Gene));
+        }
+    }
+    return genome;
+}
+
+//-------------------------------------------------------------------------
+std::vector<uint64_t> PhylogenyReader::Ancestors(uint64_t id) const
+{
+    std::vector<uint64_t> ancestors;
+    if (id == 0 || id > m_Count) {
+        return ancestors;
+    }
+    for (uint64_t parent = m_pParents[2 * (id - 1)]; parent != 0; parent = m_pParents[2 * (parent - 1)]) {
+        ancestors.push_back(parent);
+    }
+    return ancestors;
+}
+
+//-------------------------------------------------------------------------
+std::vector<uint64_t> PhylogenyReader::Descendants(uint64_t id) const
+{
+    std::vector<uint64_t> descendants;
+    if (id == 0 || id > m_Count) {
+        return descendants;
+    }
+    // Children have larger ids than their parents. Expanding the pending ids in ascending
+    // order visits a birth that descends through both parents once.
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> pending;
+    auto queueChildren = [&](uint64_t parent) {
+        for (uint64_t child = m_pChildren[parent - 1]; child > parent && child <= m_Count; ) {
+            pending.push(child);
+            const bool primary = m_pParents[2 * (child - 1)] == parent;
+            const uint64_t sibling = m_pSiblings[2 * (child - 1) + (primary ? 0 : 1)];
+            // The siblings get older along the list, anything else is a damaged store.
+            child = sibling < child ? sibling : 0;
+        }
+    };
+    queueChildren(id);
+    while (!pending.empty()) {
+        const uint64_t descendant = pending.top();
+        pending.pop();
+        if (descendants.empty() || descendants.back() != descendant) {
+            descendants.push_back(descendant);
+            queueChildren(descendant);
+        }
+    }
+    return descendants;
+}
+
+//-------------------------------------------------------------------------
+uint64_t PhylogenyReader::CommonAncestor(const std::vector<uint64_t>& ids, unsigned& generations) const
+{
+    generations = 0;
+    std::set<uint64_t> lines;
+    unsigned youngest = 0;
+    for (uint64_t id : ids) {
+        if (id == 0 || id > m_Count) {
+            return 0;
+        }
+        lines.insert(id);
+        youngest = std::max(youngest, m_pGenerations[id - 1]);
+    }
+    // Replace the youngest line by its parent until the lines have merged.
+    while (lines.size() > 1) {
+        const uint64_t id = *lines.rbegin();
+        lines.erase(id);
+        const uint64_t parent = m_pParents[2 * (id - 1)];
+        if (parent == 0) {
+            return 0;
+        }
+        lines.insert(parent);
+    }
+    if (lines.empty()) {
+        return 0;
+    }
+    generations = youngest - m_pGenerations[*lines.begin() - 1];
+    return *lines.begin();
+}
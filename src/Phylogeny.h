@@ -0,0 +1,223 @@
+#pragma once
+
+#include "BasicTypes.h"
+#include "Genome.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class Parameters;
+
+// Phylogeny store layout, one file per column in Parameters::logDir/phylogeny, native
+// byte order. Row n of every column belongs to the birth with the lineage id n + 1:
+//   generation.col:  uint32 generation of the birth
+//   parents.col:     uint64 primary parent id, uint64 secondary parent id, 0 if none
+//   mutations.col:   Phylogeny::MutationRecord
+//   genes.idx:       uint64 offset of the birth's genes in genes.dat
+//   children.col:    uint64 id of the birth's youngest child, 0 if none; rewritten when
+//                    another child is born
+//   siblings.col:    uint64 next older child of the primary parent, uint64 next older child
+//                    of the secondary parent, 0 if none or if both parents are the same
+//   genes.dat:       a keyframe holds genomeLength genes, a delta holds changedGenes
+//                    uint16 positions followed by changedGenes genes
+// The genome of a delta is the genome of the primary parent with removedGenes genes
+// erased at removedAt, resized to genomeLength, and the changed genes set.
+
+namespace Phylogeny
+{
+    //! Marks a keyframe in MutationRecord::removedAt.
+    constexpr uint16_t cKeyframe = 0xffff;
+    //! No parent, e.g. in PhylogenyRecorder::AddBirth().
+    constexpr unsigned cNoParent = ~0u;
+
+    //! Summarizes how a genome differs from the primary parent's.
+    struct MutationRecord {
+        uint16_t genomeLength;
+        uint16_t changedGenes;  ///< Genes that differ after the removal.
+        uint16_t removedGenes;
+        uint16_t removedAt;     ///< cKeyframe if the genes are stored in full.
+    };
+}
+
+/*! \class PhylogenyRecorder
+    \brief Records every birth with its parents and its genome in the phylogeny store.
+
+    Each peep gets a lineage id at birth, counting up from 1 over the whole run; survivors
+    keep theirs. A genome is stored as the delta to its primary parent's, most children
+    differ by a few genes. Every cMaxChain generations of a lineage, and whenever the
+    delta would not be smaller, the genome is stored in full to bound the reconstruction.
+    The births of a spawn are collected in per-thread buffers, numbered in peep index order
+    and appended to the store by a writer thread, see Parameters::savePhylogeny.
+*/
+class PhylogenyRecorder
+{
+public:
+    PhylogenyRecorder(const Parameters& params);
+    //! Writes the pending births, then stops the writer thread.
+    ~PhylogenyRecorder();
+
+    //! Starts the births of a generation. \a parents are the peeps the children are
+    //! derived from; AddBirth() refers to them by their position in the container.
+    //! Called in single-thread mode.
+    void BeginSpawn(unsigned generation, const std::vector<std::pair<PeepIndex, float>>& parents);
+    //! Records the birth of the peep \a index. \a primaryParent is the position of the parent
+    //! whose genome is the base of \a genome, cNoParent for random genomes.
+    //! May be called from several threads, each peep once per spawn.
+    void AddBirth(
+        PeepIndex index,
+        unsigned primaryParent,
+        unsigned secondaryParent,
+        const Genetics::Genome& genome,
+        const Genetics::Genome* pPrimaryGenome);
+    //! Numbers the births and hands them to the writer thread. Called in single-thread mode.
+    void EndSpawn();
+    //! Waits until all births are written.
+    void Flush();
+
+    //! Returns the lineage id of the peep, 0 if unknown.
+    uint64_t GetId(PeepIndex index) const { return index < m_Ids.size() ? m_Ids[index] : 0; }
+    //! Returns the lineage id of the next birth.
+    uint64_t NextId() const { return m_NextId; }
+    //! Returns the lineage ids indexed like the peeps, empty if nothing is recorded.
+    const std::vector<uint64_t>& Ids() const { return m_Ids; }
+    //! Continues the store of a restored checkpoint. Drops the births not saved in it, and
+    //! restarts the store if it lacks births of the checkpoint. Must be called before the
+    //! first generation runs.
+    void Resume(uint64_t nextId, const std::vector<uint64_t>& ids);
+
+private:
+    static constexpr unsigned cMaxChain = 64;       ///< Deltas between two keyframes of a lineage.
+    static constexpr size_t cMaxQueuedBatches = 4;  ///< The sim thread waits for the writer beyond.
+
+    //! A birth in a thread buffer.
+    struct Birth {
+        PeepIndex index;
+        unsigned primaryParent;
+        unsigned secondaryParent;
+        Phylogeny::MutationRecord mutations;
+        size_t dataOffset;      ///< In the thread buffer's data.
+        size_t dataSize;
+    };
+    struct ThreadBuffer {
+        std::vector<Birth> births{};
+        std::vector<uint8_t> data{};
+    };
+    //! The columns of the births of one spawn.
+    struct Batch {
+        std::vector<uint32_t> generations{};
+        std::vector<uint64_t> parents{};
+        std::vector<Phylogeny::MutationRecord> mutations{};
+        std::vector<uint64_t> dataOffsets{};
+        std::vector<uint64_t> siblings{};
+        std::vector<std::pair<uint64_t, uint64_t>> youngestChildren{};  ///< Parent id and its new youngest child.
+        std::vector<uint8_t> data{};
+    };
+
+    //! Runs in the writer thread until m_Stop is set and the queue is empty.
+    void WriterLoop();
+    //! Appends the batch to the column files.
+    void Write(const Batch& batch);
+    //! Queues m_xPending for the writer.
+    void QueuePending();
+    //! Cuts the store to the first \a count births. Returns false if it has fewer.
+    bool TruncateStore(uint64_t count);
+
+    const Parameters&                           m_Params;
+    std::string                                 m_Directory{};
+
+    // Sim thread only.
+    bool                                        m_Spawning{false};
+    unsigned                                    m_Generation{};
+    uint64_t                                    m_NextId{1};
+    uint64_t                                    m_DataSize{};           ///< Size of genes.dat after the queued batches.
+    std::vector<uint64_t>                       m_Ids{};                ///< Lineage ids indexed like the peeps.
+    std::vector<uint16_t>                       m_Chains{};             ///< Deltas since the last keyframe, indexed like the peeps.
+    std::vector<uint64_t>                       m_YoungestChildren{};   ///< Id of the youngest child, indexed like the peeps.
+    std::vector<uint64_t>                       m_ParentIds{};          ///< Ids of the parents of the spawn.
+    std::vector<uint16_t>                       m_ParentChains{};
+    std::vector<PeepIndex>                      m_ParentIndexes{};
+    std::vector<uint64_t>                       m_ParentYoungestChildren{};
+    std::vector<ThreadBuffer>                   m_ThreadBuffers{};
+    std::unique_ptr<Batch>                      m_xPending{};           ///< The last spawn, queued with the next one so that
+                                                                        ///< Resume() can drop the spawn before a restore.
+
+    std::mutex                                  m_Mutex{};
+    std::condition_variable                     m_Wakeup{};             ///< Signals new batches to the writer.
+    std::condition_variable                     m_Written{};            ///< Signals written batches to the sim thread.
+    std::deque<std::unique_ptr<Batch>>          m_Queue{};
+    bool                                        m_Writing{false};
+    bool                                        m_Truncate{true};       ///< The first write replaces the store of an earlier run.
+    bool                                        m_Stop{false};
+
+    std::thread                                 m_Writer{};             ///< Started last, stopped first.
+};
+
+/*! \class PhylogenyReader
+    \brief Answers lineage queries from a store written by PhylogenyRecorder.
+
+    The column files are mapped, not read, so the store may be far larger than the memory.
+    Parents always have smaller lineage ids than their children. Ancestors(), GetGenome()
+    and CommonAncestor() walk backwards through the parents. Descendants() walks forwards
+    through the child index: the youngest child of each birth and, per child, the next older
+    child of each parent. It costs O(d log d) for d descendants plus the length of their
+    sibling lists, independent of the size of the store.
+*/
+class PhylogenyReader
+{
+public:
+    //! A birth as stored.
+    struct Record {
+        unsigned generation;
+        uint64_t primaryParent;
+        uint64_t secondaryParent;
+        Phylogeny::MutationRecord mutations;
+    };
+
+    PhylogenyReader() = default;
+    PhylogenyReader(const PhylogenyReader&) = delete;
+    PhylogenyReader& operator=(const PhylogenyReader&) = delete;
+    ~PhylogenyReader();
+
+    //! Maps the store in \a directory. Returns false if it is missing or inconsistent.
+    bool Open(const std::string& directory);
+    //! Returns the count of births, the highest lineage id.
+    uint64_t Count() const { return m_Count; }
+    //! Returns the birth with lineage id \a id, 1..Count().
+    Record Get(uint64_t id) const;
+    //! Rebuilds the genome of \a id from its last keyframe.
+    Genetics::Genome GetGenome(uint64_t id) const;
+    //! Returns the primary parents of \a id up to the root, nearest first.
+    std::vector<uint64_t> Ancestors(uint64_t id) const;
+    //! Returns the ids that descend from \a id through any parent, in ascending order.
+    std::vector<uint64_t> Descendants(uint64_t id) const;
+    //! Returns the most recent common ancestor of \a ids on their primary lines, 0 if the
+    //! lines reach different roots. \a generations receives the generations from the
+    //! ancestor to the youngest of \a ids.
+    uint64_t CommonAncestor(const std::vector<uint64_t>& ids, unsigned& generations) const;
+
+private:
+    struct Mapping {
+        void* pData{nullptr};
+        size_t size{};
+    };
+    enum Column : unsigned { Generations, Parents, Mutations, DataOffsets, Children, Siblings, Data, ColumnCount };
+
+    void Close();
+
+    Mapping                                     m_Mappings[ColumnCount]{};
+    uint64_t                                    m_Count{};
+    const uint32_t*                             m_pGenerations{nullptr};
+    const uint64_t*                             m_pParents{nullptr};
+    const Phylogeny::MutationRecord*            m_pMutations{nullptr};
+    const uint64_t*                             m_pDataOffsets{nullptr};
+    const uint64_t*                             m_pChildren{nullptr};
+    const uint64_t*                             m_pSiblings{nullptr};
+    const uint8_t*                              m_pData{nullptr};
+};
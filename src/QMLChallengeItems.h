@@ -83,6 +83,7 @@ public:
         CompletedTasks,
         AvgAge,
         SurvivorToNextGen,
+        GenerationTimes,
         NoOfAnalytics
     };
     Q_ENUM(Value)
@@ -22,6 +22,7 @@
 #include "Challenges/RightQuarter.h"
 #include "Challenges/RadioactiveWalls.h"
 #include "Challenges/TouchAnyWall.h"
+#include "FrameRecorder.h"
 
 #include <iostream>
 
@@ -48,6 +49,10 @@ QObject* QMLInterface::StartBackend()
     qRegisterMetaType<QML::CircleBarrierSetup>("CircleBarrierSetup");
     qRegisterMetaType<QML::RectBarrierSetup>("RectBarrierSetup");
     m_pBackendWorker = new Backend();
+    if (auto pEngine = qmlEngine(this)) {
+        // The engine takes the ownership of the provider.
+        pEngine->addImageProvider("signals", new SignalImageProvider(*this));
+    }
     m_pBackendWorker->moveToThread(&m_WorkerThread);
     connect(&m_WorkerThread, &QThread::finished, m_pBackendWorker, &Backend::deleteLater);
     connect(&m_WorkerThread, &QThread::started, m_pBackendWorker, &Backend::Run);
@@ -364,10 +369,111 @@ WorldData QMLInterface::GetWorldData()
 {
     m_Mutex.lock();
     auto data = m_pBackendWorker->GetWorldData();
+    if (m_xReplay) {
+        data.generation = m_xReplay->Generation();
+        data.simStep = m_xReplay->Step();
+    }
     m_Mutex.unlock();
     return data;
 }
 
+//---------------------------------------------------------------------------
+void QMLInterface::GetPeepSprites(std::vector<PeepSprite>& sprites)
+{
+    m_Mutex.lock();
+    if (m_xReplay) {
+        sprites.clear();
+        const auto& alive = m_xReplay->Alive();
+        const auto& locations = m_xReplay->Locations();
+        const auto& colors = m_xReplay->Colors();
+        for (unsigned index = 1; index <= m_xReplay->Population(); ++index) {
+            if (alive[index]) {
+                QColor color = ConvertUint8ToQColor(colors[index]);
+                sprites.push_back({locations[index].x, locations[index].y,
+                    uint8_t(color.red()), uint8_t(color.green()), uint8_t(color.blue())});
+            }
+        }
+    } else {
+        m_pBackendWorker->GetPeepSprites(sprites);
+    }
+    m_Mutex.unlock();
+}
+
+//---------------------------------------------------------------------------
+bool QMLInterface::OpenTrajectory(unsigned generation)
+{
+    auto xReplay = std::make_unique<TrajectoryReplay>();
+    if (!xReplay->Open(m_pBackendWorker->GetTrajectoryPath(generation))) {
+        return false;
+    }
+    m_Mutex.lock();
+    m_xReplay = std::move(xReplay);
+    m_Mutex.unlock();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void QMLInterface::CloseTrajectory()
+{
+    m_Mutex.lock();
+    m_xReplay.reset();
+    m_Mutex.unlock();
+}
+
+//---------------------------------------------------------------------------
+bool QMLInterface::IsTrajectoryOpen() const
+{
+    m_Mutex.lock();
+    const bool open = m_xReplay != nullptr;
+    m_Mutex.unlock();
+    return open;
+}
+
+//---------------------------------------------------------------------------
+unsigned QMLInterface::GetTrajectoryStepCount() const
+{
+    m_Mutex.lock();
+    const unsigned count = m_xReplay ? m_xReplay->StepCount() : 0;
+    m_Mutex.unlock();
+    return count;
+}
+
+//---------------------------------------------------------------------------
+unsigned QMLInterface::GetTrajectoryStep() const
+{
+    m_Mutex.lock();
+    const unsigned step = m_xReplay ? m_xReplay->Step() : 0;
+    m_Mutex.unlock();
+    return step;
+}
+
+//---------------------------------------------------------------------------
+bool QMLInterface::SeekTrajectory(unsigned step)
+{
+    m_Mutex.lock();
+    const bool sought = m_xReplay && m_xReplay->Seek(step);
+    m_Mutex.unlock();
+    return sought;
+}
+
+//---------------------------------------------------------------------------
+bool QMLInterface::StepTrajectory()
+{
+    m_Mutex.lock();
+    const bool stepped = m_xReplay && m_xReplay->Advance();
+    m_Mutex.unlock();
+    return stepped;
+}
+
+//---------------------------------------------------------------------------
+QImage QMLInterface::GetSignalLayerImage(unsigned layer)
+{
+    m_Mutex.lock();
+    auto image = m_pBackendWorker->GetSignalLayerImage(layer);
+    m_Mutex.unlock();
+    return image;
+}
+
 //---------------------------------------------------------------------------
 QVariantList QMLInterface::GetSensorNames()
 {
@@ -535,6 +641,25 @@ QVariantList QMLInterface::GetCompletedChallengeTaskCounts() const
     return lineGraphs;
 }
 
+//-------------------------------------------------------------------------
+QVariantList QMLInterface::GetGenerationTimes() const
+{
+    QVariantList lineGraphs{};
+    QList<QVariant> dataUI{};
+    auto dataVector = m_pBackendWorker->GetGenerationTimes();
+    for (const auto& times : dataVector.second)
+    {
+        for (size_t j = 0; j < times.size(); ++j)
+        {
+            dataUI.push_back(QPointF(dataVector.first + j, times.at(j)));
+        }
+        lineGraphs.push_back(dataUI);
+        dataUI.clear();
+    }
+
+    return lineGraphs;
+}
+
 //-------------------------------------------------------------------------
 QVariantList QMLInterface::GetAnalyticsNames() const
 {
@@ -560,4 +685,22 @@ QSize QMLInterface::GetFrameSize() const
     return QSize(size.first, size.second);
 }
 
+//-------------------------------------------------------------------------
+SignalImageProvider::SignalImageProvider(QMLInterface& interface)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_Interface(interface)
+{
+
+}
+
+//-------------------------------------------------------------------------
+QImage SignalImageProvider::requestImage(const QString& id, QSize* size, const QSize&)
+{
+    auto image = m_Interface.GetSignalLayerImage(id.section('/', 0, 0).toUInt());
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
+
 } // namespace QML
@@ -2,14 +2,17 @@
 
 #include "QMLChallengeItems.h"
 #include "Backend.h"
+#include "Trajectory.h"
 
 #include <QMetaType>
 #include <QMutex>
 #include <QObject>
 #include <QQmlEngine>
+#include <QQuickImageProvider>
 #include <QThread>
 
 #include <cstdint>
+#include <memory>
 
 class Backend;
 
@@ -43,8 +46,31 @@ public:
 
     Q_INVOKABLE unsigned GetChallengeId() const;
     Q_INVOKABLE void SetChallengeId(unsigned id);
-    //! Returns the world data of the current simulation step.
+    //! Returns the world data of the current simulation step, or the generation and step
+    //! of the replayed trajectory.
     Q_INVOKABLE WorldData GetWorldData();
+    //! Copies the living peeps of the last sim step, see Backend::GetPeepSprites(), or
+    //! those of the replayed step.
+    void GetPeepSprites(std::vector<PeepSprite>& sprites);
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //! Trajectory replay, see Parameters::saveTrajectories. While a trajectory is open
+    //! the canvas shows its peeps instead of the running simulation.
+    //! Opens the trajectory of \a generation at step 0. Returns false if it wasn't saved.
+    Q_INVOKABLE bool OpenTrajectory(unsigned generation);
+    //! Returns to the simulation.
+    Q_INVOKABLE void CloseTrajectory();
+    Q_INVOKABLE bool IsTrajectoryOpen() const;
+    //! Returns the count of the recorded sim steps, 0 if no trajectory is open.
+    Q_INVOKABLE unsigned GetTrajectoryStepCount() const;
+    Q_INVOKABLE unsigned GetTrajectoryStep() const;
+    //! Moves to the start of \a step, see TrajectoryReplay::Seek().
+    Q_INVOKABLE bool SeekTrajectory(unsigned step);
+    //! Plays the current step, returns false at the end, see TrajectoryReplay::Advance().
+    Q_INVOKABLE bool StepTrajectory();
+    ///////////////////////////////////////////////////////////////////////////////
+    //! Returns a pheromone layer as a grayscale image, see Backend::GetSignalLayerImage().
+    QImage GetSignalLayerImage(unsigned layer);
 
     ///////////////////////////////////////////////////////////////////////////////
     //! QML invokable getters for challenge UI setups
@@ -86,6 +112,7 @@ public:
     Q_INVOKABLE QVariantList GetAvgAges() const;
     Q_INVOKABLE QVariantList GetGeneticDiversity() const;
     Q_INVOKABLE QVariantList GetCompletedChallengeTaskCounts() const;
+    Q_INVOKABLE QVariantList GetGenerationTimes() const;
     Q_INVOKABLE QVariantList GetAnalyticsNames() const;
     Q_INVOKABLE void ClearAnalyticsProcessedCount();
     ///////////////////////////////////////////////////////////////////////////////
@@ -94,9 +121,22 @@ private:
     //! Enlarge the simulation data.
     const int cUiScaling = 6;
 
-    QMutex      m_Mutex;
+    mutable QMutex  m_Mutex;
     QThread     m_WorkerThread;     ///< Worker thread.
     Backend*    m_pBackendWorker;   ///< Pointer to the backend worker
+    std::unique_ptr<TrajectoryReplay> m_xReplay{};  ///< The open trajectory, guarded by m_Mutex.
+};
+
+//! Serves the pheromone layers to QML as "image://signals/<layer>/<frame>".
+//! The frame part only makes every request unique, so that QML reloads the image.
+class SignalImageProvider : public QQuickImageProvider
+{
+public:
+    SignalImageProvider(QMLInterface& interface);
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+private:
+    QMLInterface& m_Interface;
 };
 
 } // namespace QML
\ No newline at end of file
@@ -1,78 +1,96 @@
 #include "Random.h"
 
-#include <random>
 #include <chrono>
-#include <cassert>
+#include <cstring>
+#include <random>
 
 // Default is determinstic
 RandomUintGenerator::RandomUintGenerator(bool deterministic)
 {
     if (deterministic) {
-        // for Marsaglia
-        rngx = 123456789;
-        rngy = 362436000;
-        rngz = 521288629;
-        rngc = 7654321;
-
-        // for Jenkins:
-        a = 0xf1ea5eed, b = c = d = 123456789;
+        seed(0xf1ea5eed075bcd15ULL);
     } else {
         randomize();
     }
 }
 
 
+// The seed and the stream make one 64 bit counter.
+RandomUintGenerator::RandomUintGenerator(uint32_t seed, uint32_t stream)
+{
+    this->seed((uint64_t(seed) << 32) | stream);
+}
+
+
 void RandomUintGenerator::randomize()
 {
     std::mt19937 generator(time(0));  // mt19937 is a standard mersenne_twister_engine
+    seed((uint64_t(generator()) << 32) | generator());
+}
+
 
-    // for Marsaglia
-    do { rngx = generator(); } while (rngx == 0);
-    do { rngy = generator(); } while (rngy == 0);
-    do { rngz = generator(); } while (rngz == 0);
-    do { rngc = generator(); } while (rngc == 0);
+// splitmix64 is the seeding its authors recommend for xoshiro, the words of
+// neighbouring counters are unrelated. A lane must not be all zeros.
+void RandomUintGenerator::seed(uint64_t counter)
+{
+    auto splitmix = [&counter]() {
+        uint64_t z = (counter += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    };
+    for (unsigned lane = 0; lane < cLanes; ++lane) {
+        const uint64_t low = splitmix();
+        const uint64_t high = splitmix();
+        m_Lanes[0][lane] = uint32_t(low);
+        m_Lanes[1][lane] = uint32_t(low >> 32);
+        m_Lanes[2][lane] = uint32_t(high);
+        m_Lanes[3][lane] = uint32_t(high >> 32) | (low == 0 && uint32_t(high) == 0);
+    }
+    m_Position = cBlockSize;
+}
 
-    // for Jenkins:
-    a = 0xf1ea5eed, b = c = d = generator();
+
+RandomUintGenerator::State RandomUintGenerator::state() const
+{
+    State state;
+    std::memcpy(state.lanes, m_Lanes, sizeof(m_Lanes));
+    std::memcpy(state.block, m_Block, sizeof(m_Block));
+    state.position = m_Position;
+    return state;
 }
 
 
-// This algorithm is from http://www0.cs.ucl.ac.uk/staff/d.jones/GoodPracticeRNG.pdf
-// where it is attributed to G. Marsaglia.
-//
-uint32_t RandomUintGenerator::operator()()
+void RandomUintGenerator::setState(const State& state)
 {
-    if (false) {
-        // Marsaglia
-        uint64_t t, a = 698769069ULL;
-        rngx = 69069 * rngx + 12345;
-        rngy ^= (rngy << 13);
-        rngy ^= (rngy >> 17);
-        rngy ^= (rngy << 5); /* y must never be set to zero! */
-        t = a * rngz + rngc;
-        rngc = (t >> 32);/* Also avoid setting z=c=0! */
-        return rngx + rngy + (rngz = t);
-    } else {
-        // Jenkins
-        #define rot32(x,k) (((x)<<(k))|((x)>>(32-(k))))
-        uint32_t e = a - rot32(b, 27);
-        a = b ^ rot32(c, 17);
-        b = c + d;
-        c = d + e;
-        d = e + a;
-        return d;
-    }
+    std::memcpy(m_Lanes, state.lanes, sizeof(m_Lanes));
+    std::memcpy(m_Block, state.block, sizeof(m_Block));
+    m_Position = state.position <= cBlockSize ? state.position : cBlockSize;
 }
 
 
-// Sure, there's a bias when using modulus operator where (max - min) is not
-// a power of two, but we don't care if we generate one value a little more
-// often than another. Our randomness does not have to be any better quality
-// than the randomness of a shotgun. We do care about speed, because this will
-// get called inside deeply nested inner loops.
-//
-unsigned RandomUintGenerator::operator()(unsigned min, unsigned max)
+// xoshiro128** by D. Blackman and S. Vigna, https://prng.di.unimi.it. The lanes
+// are independent, each round of the inner loop becomes a few vector instructions.
+void RandomUintGenerator::refill()
 {
-    assert(max >= min);
-    return ((*this)() % (max - min + 1)) + min;
-}
\ No newline at end of file
+    auto rotl = [](uint32_t x, int k) { return (x << k) | (x >> (32 - k)); };
+    uint32_t* s0 = m_Lanes[0];
+    uint32_t* s1 = m_Lanes[1];
+    uint32_t* s2 = m_Lanes[2];
+    uint32_t* s3 = m_Lanes[3];
+    for (unsigned round = 0; round < cBlockSize / cLanes; ++round) {
+        uint32_t* pOut = m_Block + round * cLanes;
+#pragma omp simd
+        for (unsigned lane = 0; lane < cLanes; ++lane) {
+            pOut[lane] = rotl(s1[lane] * 5, 7) * 9;
+            const uint32_t t = s1[lane] << 9;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = rotl(s3[lane], 11);
+        }
+    }
+    m_Position = 0;
+}
@@ -4,19 +4,65 @@
 
 constexpr uint32_t RANDOM_UINT_MAX = 0xffffffff;
 
+/*! \class RandomUintGenerator
+    \brief Fast random numbers for the simulation, not for cryptography.
+
+    cLanes independent xoshiro128** generators are stepped together, so the compiler
+    turns a refill into vector instructions. Each refill produces a block of cBlockSize
+    numbers that the calls hand out one after the other. Every thread works with its own
+    generator, the blocks need no locking.
+*/
 class RandomUintGenerator{
-private:
-    // for Marsaglia
-    uint32_t rngx;
-    uint32_t rngy;
-    uint32_t rngz;
-    uint32_t rngc;
-    // for Jenkins
-    uint32_t a, b, c, d;
 public:
+    static constexpr unsigned cLanes = 8;
+    static constexpr unsigned cBlockSize = 4 * cLanes;
+
+    //! The complete generator state, for checkpoints.
+    struct State {
+        uint32_t lanes[4][cLanes];      ///< xoshiro128** words, after the current block.
+        uint32_t block[cBlockSize];
+        uint32_t position;              ///< Next number of the block, cBlockSize if used up.
+    };
+
     RandomUintGenerator(bool deterministic = false);
+    //! Seeds the generator from a counter, e.g. a peep index, so that work split among
+    //! threads draws the same numbers regardless of the thread count. Different \a stream
+    //! values of one \a seed give unrelated sequences.
+    RandomUintGenerator(uint32_t seed, uint32_t stream);
     RandomUintGenerator& operator=(const RandomUintGenerator &rhs) = default;
     void randomize();
-    uint32_t operator()();
-    unsigned operator()(unsigned min, unsigned max);
+    State state() const;
+    void setState(const State& state);
+
+    //! Returns 0..RANDOM_UINT_MAX.
+    uint32_t operator()()
+    {
+        if (m_Position == cBlockSize) {
+            refill();
+        }
+        return m_Block[m_Position++];
+    }
+
+    //! Returns min..max. Lemire's multiply and shift replaces the modulo, it has a bias
+    //! below (max - min + 1) / 2^32 just like the modulo had. Our randomness does not
+    //! have to be any better quality than the randomness of a shotgun.
+    unsigned operator()(unsigned min, unsigned max)
+    {
+        const uint32_t range = max - min + 1;
+        const uint32_t value = (*this)();
+        return range == 0 ? value : min + uint32_t((uint64_t(value) * range) >> 32);
+    }
+
+    //! Returns 0.0..1.0, excluding 1.0, from the upper 24 bits without a division.
+    float uniform() { return ((*this)() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+    //! Spreads the 64 bit \a counter over the lanes with splitmix64.
+    void seed(uint64_t counter);
+    //! Steps all lanes cBlockSize / cLanes times into m_Block.
+    void refill();
+
+    alignas(32) uint32_t m_Lanes[4][cLanes];
+    alignas(32) uint32_t m_Block[cBlockSize];
+    unsigned m_Position{cBlockSize};
 };
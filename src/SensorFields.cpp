@@ -0,0 +1,317 @@
+#include "SensorFields.h"
+
+#include "Genome.h"
+#include "Grid.h"
+#include "Parameters.h"
+#include "Peep.h"
+#include "PeepsPool.h"
+#include "PheromoneSignals.h"
+#include "SensorPyramids.h"
+#include "SensorsActions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//-------------------------------------------------------------------------
+SensorFields::SensorFields(const Parameters& params)
+    : m_Params(params)
+{
+
+}
+
+//-------------------------------------------------------------------------
+std::vector<SensorFields::Tap> SensorFields::MakeTaps(float radius)
+{
+    std::vector<Tap> taps;
+    for (int dx = -(int)radius; dx <= (int)radius; ++dx) {
+        int extentY = (int)std::sqrt(radius * radius - dx * dx);
+        for (int dy = -extentY; dy <= extentY; ++dy) {
+            Tap tap{};
+            tap.dx = dx;
+            tap.dy = dy;
+            tap.w = 1.0f;
+            if (dx != 0 || dy != 0) {
+                tap.wx = (float)dx / (dx * dx + dy * dy);
+                tap.wy = (float)dy / (dx * dx + dy * dy);
+            }
+            taps.push_back(tap);
+        }
+    }
+    return taps;
+}
+
+//-------------------------------------------------------------------------
+void SensorFields::Init()
+{
+    m_SizeX = m_Params.sizeX;
+    m_SizeY = m_Params.sizeY;
+    m_TilesX = (m_SizeX + cTileSize - 1) / cTileSize;
+    m_TilesY = (m_SizeY + cTileSize - 1) / cTileSize;
+    m_Active.fill(false);
+    if (!m_Params.precomputeSensorFields) {
+        // Nothing is allocated, the sensors use the direct neighborhood walk.
+        m_Occupancy = Source{};
+        m_Signal0 = Source{};
+        return;
+    }
+
+    for (uint8_t d = 0; d < m_AxisUnit.size(); ++d) {
+        Coord dirVec = Dir(static_cast<Compass>(d)).asNormalizedCoord();
+        float len = std::sqrt(dirVec.x * dirVec.x + dirVec.y * dirVec.y);
+        m_AxisUnit[d] = len > 0.0f ? std::array<float, 2>{ dirVec.x / len, dirVec.y / len } : std::array<float, 2>{};
+    }
+
+    m_PopulationTaps = MakeTaps(m_Params.populationSensorRadius);
+    m_SignalTaps = MakeTaps(m_Params.signalSensorRadius);
+
+    auto initSource = [this](Source& source, unsigned pad) {
+        source.pad = pad;
+        source.stride = m_SizeY + 2 * pad;
+        source.cells.assign((m_SizeX + 2 * pad) * source.stride, 0.0f);
+        source.fullRefresh = true;
+    };
+    initSource(m_Occupancy, (unsigned)m_Params.populationSensorRadius);
+    initSource(m_Signal0, (unsigned)m_Params.signalSensorRadius);
+
+    const size_t cellCount = m_SizeX * m_SizeY;
+    for (auto* field : { &m_PopulationCount, &m_PopulationAxisX, &m_PopulationAxisY, &m_PopulationInvLocs,
+                         &m_SignalSum, &m_SignalInvMax, &m_SignalAxisX, &m_SignalAxisY }) {
+        field->assign(cellCount, 0.0f);
+    }
+
+    // The neighborhood is clipped at the world borders, so the normalization terms
+    // are the same stencils applied to a layer of ones.
+    Source inside;
+    initSource(inside, std::max(m_Occupancy.pad, m_Signal0.pad));
+    for (int x = 0; x < m_SizeX; ++x) {
+        std::fill_n(&inside.at(x, 0), m_SizeY, 1.0f);
+    }
+    for (unsigned tile = 0; tile < m_TilesX * m_TilesY; ++tile) {
+        ConvolveTile(inside, m_PopulationTaps, &Tap::w, nullptr, tile, m_PopulationInvLocs, nullptr);
+        ConvolveTile(inside, m_SignalTaps, &Tap::w, nullptr, tile, m_SignalInvMax, nullptr);
+        ConvolveTile(inside, m_SignalTaps, &Tap::wx, &Tap::wy, tile, m_SignalAxisX, &m_SignalAxisY);
+    }
+    for (size_t i = 0; i < cellCount; ++i) {
+        m_PopulationInvLocs[i] = 1.0f / m_PopulationInvLocs[i];
+        m_SignalInvMax[i] = 1.0f / (m_SignalInvMax[i] * SIGNAL_MAX);
+    }
+}
+
+//-------------------------------------------------------------------------
+void SensorFields::SelectFields(const PeepsPool& peeps, const Sensors& sensors)
+{
+    std::array<bool, static_cast<size_t>(eField::NoOfFields)> selected{};
+    // The long-radius sensors are served by the pyramids.
+    const bool population = !SensorPyramids::Covers(m_Params.populationSensorRadius, m_Params);
+    const bool signal = !SensorPyramids::Covers(m_Params.signalSensorRadius, m_Params);
+    if (m_Params.precomputeSensorFields && !m_Occupancy.cells.empty()) {
+        const auto& types = sensors.AvailableTypes();
+        for (unsigned index = 1; index <= m_Params.population; ++index) {
+            for (const auto& conn : peeps[index].nnet.connections) {
+                if (conn.sourceType != Genetics::SENSOR || conn.sourceNum >= types.size()) {
+                    continue;
+                }
+                switch (types[conn.sourceNum]) {
+                case Sensors::eType::POPULATION:
+                    selected[static_cast<size_t>(eField::Population)] = population;
+                    break;
+                case Sensors::eType::POPULATION_FWD:
+                case Sensors::eType::POPULATION_LR:
+                    selected[static_cast<size_t>(eField::PopulationAxis)] = population;
+                    break;
+                case Sensors::eType::SIGNAL0:
+                    selected[static_cast<size_t>(eField::Signal0)] = signal && m_Params.signalLayers > 0;
+                    break;
+                case Sensors::eType::SIGNAL0_FWD:
+                case Sensors::eType::SIGNAL0_LR:
+                case Sensors::eType::SIGNAL1_FWD:
+                case Sensors::eType::SIGNAL1_LR:
+                case Sensors::eType::SIGNAL2_FWD:
+                case Sensors::eType::SIGNAL2_LR:
+                case Sensors::eType::SIGNAL3_FWD:
+                case Sensors::eType::SIGNAL3_LR:
+                    // Geometry only, shared by all the layers.
+                    selected[static_cast<size_t>(eField::Signal0Axis)] = signal && m_Params.signalLayers > 0;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    // A newly selected field has never been computed, even if its source did not change.
+    auto newlySelected = [&](eField field) {
+        return selected[static_cast<size_t>(field)] && !IsActive(field);
+    };
+    if (newlySelected(eField::Population) || newlySelected(eField::PopulationAxis)) {
+        m_Occupancy.fullRefresh = true;
+    }
+    if (newlySelected(eField::Signal0)) {
+        m_Signal0.fullRefresh = true;
+    }
+    m_Active = selected;
+}
+
+//-------------------------------------------------------------------------
+template <typename F>
+std::vector<unsigned> SensorFields::RefreshSource(Source& source, F&& read)
+{
+    const unsigned tileCount = m_TilesX * m_TilesY;
+    std::vector<uint8_t> dirty(tileCount, source.fullRefresh);
+
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(static)
+    for (unsigned tile = 0; tile < tileCount; ++tile) {
+        const int x0 = (tile / m_TilesY) * cTileSize;
+        const int y0 = (tile % m_TilesY) * cTileSize;
+        const int x1 = std::min<int>(x0 + cTileSize, m_SizeX);
+        const int y1 = std::min<int>(y0 + cTileSize, m_SizeY);
+        for (int16_t x = x0; x < x1; ++x) {
+            for (int16_t y = y0; y < y1; ++y) {
+                float value = read(Coord{x, y});
+                float& cell = source.at(x, y);
+                if (cell != value) {
+                    cell = value;
+                    dirty[tile] = true;
+                }
+            }
+        }
+    }
+    source.fullRefresh = false;
+
+    // A changed cell affects the fields within the sensor radius around it.
+    const int halo = (source.pad + cTileSize - 1) / cTileSize;
+    std::vector<unsigned> tiles;
+    for (int tx = 0; tx < (int)m_TilesX; ++tx) {
+        for (int ty = 0; ty < (int)m_TilesY; ++ty) {
+            bool affected = false;
+            for (int nx = std::max(0, tx - halo); !affected && nx <= std::min<int>(m_TilesX - 1, tx + halo); ++nx) {
+                for (int ny = std::max(0, ty - halo); !affected && ny <= std::min<int>(m_TilesY - 1, ty + halo); ++ny) {
+                    affected = dirty[nx * m_TilesY + ny];
+                }
+            }
+            if (affected) {
+                tiles.push_back(tx * m_TilesY + ty);
+            }
+        }
+    }
+    return tiles;
+}
+
+//-------------------------------------------------------------------------
+void SensorFields::ConvolveTile(
+    const Source& source,
+    const std::vector<Tap>& taps,
+    float Tap::*weight0,
+    float Tap::*weight1,
+    unsigned tile,
+    std::vector<float>& out0,
+    std::vector<float>* out1) const
+{
+    const int x0 = (tile / m_TilesY) * cTileSize;
+    const int y0 = (tile % m_TilesY) * cTileSize;
+    const int x1 = std::min<int>(x0 + cTileSize, m_SizeX);
+    const int count = std::min<int>(y0 + cTileSize, m_SizeY) - y0;
+
+    // The inner loops run along a padded column, contiguous in memory and without
+    // bounds checks, so the compiler can vectorize them.
+    for (int x = x0; x < x1; ++x) {
+        float* dst0 = &out0[x * m_SizeY + y0];
+        float* dst1 = out1 ? &(*out1)[x * m_SizeY + y0] : nullptr;
+        std::fill_n(dst0, count, 0.0f);
+        if (dst1) {
+            std::fill_n(dst1, count, 0.0f);
+        }
+        for (const Tap& tap : taps) {
+            const float* src = source.column(x + tap.dx, y0 + tap.dy);
+            const float w0 = tap.*weight0;
+            for (int k = 0; k < count; ++k) {
+                dst0[k] += w0 * src[k];
+            }
+            if (dst1) {
+                const float w1 = tap.*weight1;
+                for (int k = 0; k < count; ++k) {
+                    dst1[k] += w1 * src[k];
+                }
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void SensorFields::Update(const Grid& grid, const PheromoneSignals& pheromoneSignals)
+{
+    const bool population = IsActive(eField::Population);
+    const bool populationAxis = IsActive(eField::PopulationAxis);
+    if (population || populationAxis) {
+        auto tiles = RefreshSource(m_Occupancy, [&grid](Coord loc) {
+            return grid.isOccupiedAt(loc) ? 1.0f : 0.0f;
+        });
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(dynamic)
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            if (population) {
+                ConvolveTile(m_Occupancy, m_PopulationTaps, &Tap::w, nullptr, tiles[i], m_PopulationCount, nullptr);
+            }
+            if (populationAxis) {
+                ConvolveTile(m_Occupancy, m_PopulationTaps, &Tap::wx, &Tap::wy, tiles[i], m_PopulationAxisX, &m_PopulationAxisY);
+            }
+        }
+    }
+
+    if (IsActive(eField::Signal0)) {
+        auto tiles = RefreshSource(m_Signal0, [&pheromoneSignals](Coord loc) {
+            return (float)pheromoneSignals.getMagnitude(0, loc);
+        });
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(dynamic)
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            ConvolveTile(m_Signal0, m_SignalTaps, &Tap::w, nullptr, tiles[i], m_SignalSum, nullptr);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+float SensorFields::GetPopulationDensity(Coord loc) const
+{
+    assert(IsActive(eField::Population));
+    const size_t i = Index(loc);
+    return m_PopulationCount[i] * m_PopulationInvLocs[i];
+}
+
+//-------------------------------------------------------------------------
+float SensorFields::GetPopulationDensityAlongAxis(Coord loc, Dir dir) const
+{
+    assert(IsActive(eField::PopulationAxis));
+    assert(dir != Compass::CENTER);  // require a defined axis
+
+    const size_t i = Index(loc);
+    const auto& unit = m_AxisUnit[dir.asInt()];
+    double sum = unit[0] * m_PopulationAxisX[i] + unit[1] * m_PopulationAxisY[i];
+
+    double maxSumMag = 6.0 * m_Params.populationSensorRadius;
+    double sensorVal = sum / maxSumMag; // convert to -1.0..1.0
+    return (sensorVal + 1.0) / 2.0; // convert to 0.0..1.0
+}
+
+//-------------------------------------------------------------------------
+float SensorFields::GetSignalDensity(Coord loc) const
+{
+    assert(IsActive(eField::Signal0));
+    const size_t i = Index(loc);
+    return m_SignalSum[i] * m_SignalInvMax[i];
+}
+
+//-------------------------------------------------------------------------
+float SensorFields::GetSignalDensityAlongAxis(Coord loc, Dir dir, uint8_t centerMagnitude) const
+{
+    assert(IsActive(eField::Signal0Axis));
+    assert(dir != Compass::CENTER); // require a defined axis
+
+    const size_t i = Index(loc);
+    const auto& unit = m_AxisUnit[dir.asInt()];
+    double sum = centerMagnitude * (unit[0] * m_SignalAxisX[i] + unit[1] * m_SignalAxisY[i]);
+
+    double maxSumMag = 6.0 * m_Params.signalSensorRadius * SIGNAL_MAX;
+    double sensorVal = sum / maxSumMag; // convert to -1.0..1.0
+    return (sensorVal + 1.0) / 2.0; // convert to 0.0..1.0
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Grid;
+class Parameters;
+class PeepsPool;
+class PheromoneSignals;
+class Sensors;
+
+/*! \class SensorFields
+    \brief Whole-grid precomputed fields for the neighborhood sensors.
+
+    The POPULATION*, SIGNAL0* sensors convolve the same disc shaped neighborhood
+    around every peep that reads them. Neighboring peeps share most of that
+    neighborhood, so instead this stage computes the dense fields once per sim step
+    and the sensors sample them with a single load:
+
+        population count   - occupied cells within populationSensorRadius
+        population axis    - sum of offset.x / |offset|^2 and offset.y / |offset|^2 of
+                             the occupied neighbors. Every one of the 8 sensor directions
+                             is a linear combination of these two components, so the
+                             forward and left-right sensors fold into them.
+        signal sum         - signal layer 0 magnitude within signalSensorRadius
+
+    The border normalization terms (number of in-bounds cells, the signal axis weights)
+    only depend on the world geometry and are computed once in Init().
+
+    The world is split into tiles. Each Update() diffs the grid and the signal layer
+    against the copy the fields were last computed from; only the tiles that changed,
+    dilated by the sensor radius, are recomputed. Fields not referenced by any wired
+    net of the current generation are not computed at all, the sensors fall back to
+    the direct neighborhood walk for those.
+
+    The fields are a snapshot of the world at the beginning of the sim step. Signals
+    emitted during the step are seen by the sensors in the next step.
+*/
+class SensorFields
+{
+public:
+    //! Fields computed by the stage.
+    enum class eField : uint8_t {
+        Population,       ///< Occupied cell count around each cell.
+        PopulationAxis,   ///< Directional population density components.
+        Signal0,          ///< Signal layer 0 sum around each cell.
+        Signal0Axis,      ///< Geometry only, does not need per step updates.
+        NoOfFields
+    };
+
+    SensorFields(const Parameters& params);
+
+    //! Allocates the fields and computes the geometry dependent terms.
+    //! Has to be called after the parameters are read.
+    void Init();
+    //! Selects the fields referenced by the currently wired nets.
+    //! Called once a new generation has been spawned.
+    void SelectFields(const PeepsPool& peeps, const Sensors& sensors);
+    //! Recomputes the dirty tiles of the selected fields. Called in single-thread mode
+    //! before the peeps are stepped.
+    void Update(const Grid& grid, const PheromoneSignals& pheromoneSignals);
+    //! Returns whether the field is up to date and can be sampled.
+    bool IsActive(eField field) const { return m_Active[static_cast<size_t>(field)]; }
+
+    //! Same as the POPULATION sensor. Returns 0.0..1.0.
+    float GetPopulationDensity(Coord loc) const;
+    //! Same as AlgorithmHelpers::getPopulationDensityAlongAxis(). Returns 0.0..1.0.
+    float GetPopulationDensityAlongAxis(Coord loc, Dir dir) const;
+    //! Same as SensorsActions::getSignalDensity() for layer 0. Returns 0.0..1.0.
+    float GetSignalDensity(Coord loc) const;
+    //! Same as SensorsActions::getSignalDensityAlongAxis() for layer 0. That sensor weights its
+    //! neighborhood with the magnitude of the center cell, hence the caller passes it in.
+    //! Returns 0.0..1.0.
+    float GetSignalDensityAlongAxis(Coord loc, Dir dir, uint8_t centerMagnitude) const;
+
+private:
+    //! One cell of the disc shaped neighborhood.
+    struct Tap {
+        int16_t dx;
+        int16_t dy;
+        float w;    ///< 1.0, every cell counts.
+        float wx;   ///< offset.x / |offset|^2, 0 for the center.
+        float wy;   ///< offset.y / |offset|^2, 0 for the center.
+    };
+
+    //! Copy of a source layer with a zero border of \a pad cells, so the stencils never
+    //! have to check the world bounds. Also serves as the reference for the dirty check.
+    struct Source {
+        std::vector<float> cells;
+        unsigned pad{};
+        unsigned stride{};  ///< Padded column height.
+        bool fullRefresh{true};
+        float& at(int x, int y) { return cells[(x + pad) * stride + y + pad]; }
+        const float* column(int x, int y) const { return &cells[(x + pad) * stride + y + pad]; }
+    };
+
+    static constexpr unsigned cTileSize = 16;
+
+    //! Builds the neighborhood taps the same way AlgorithmHelpers::visitNeighborhood() does.
+    static std::vector<Tap> MakeTaps(float radius);
+    //! Copies the source layer into \a source and returns the tiles of the fields to recompute.
+    template <typename F>
+    std::vector<unsigned> RefreshSource(Source& source, F&& read);
+    //! out0 (and out1 if not null) = sum of the weighted taps over the tile.
+    void ConvolveTile(
+        const Source& source,
+        const std::vector<Tap>& taps,
+        float Tap::*weight0,
+        float Tap::*weight1,
+        unsigned tile,
+        std::vector<float>& out0,
+        std::vector<float>* out1) const;
+    //! Index of a cell in the unpadded fields.
+    size_t Index(Coord loc) const { return loc.x * m_SizeY + loc.y; }
+
+    const Parameters& m_Params;
+    uint16_t m_SizeX{};
+    uint16_t m_SizeY{};
+    unsigned m_TilesX{};
+    unsigned m_TilesY{};
+
+    std::array<bool, static_cast<size_t>(eField::NoOfFields)> m_Active{};  ///< Fields computed each step.
+    std::array<std::array<float, 2>, 9> m_AxisUnit{};                      ///< Unit vectors of the Dir values.
+
+    std::vector<Tap> m_PopulationTaps{};        ///< Neighborhood of populationSensorRadius.
+    std::vector<Tap> m_SignalTaps{};            ///< Neighborhood of signalSensorRadius.
+    Source m_Occupancy{};                       ///< 1.0 where a peep lives.
+    Source m_Signal0{};                         ///< Signal layer 0 magnitudes.
+
+    std::vector<float> m_PopulationCount{};     ///< Occupied cells in the neighborhood.
+    std::vector<float> m_PopulationAxisX{};     ///< Sum of offset.x / |offset|^2 of the occupied neighbors.
+    std::vector<float> m_PopulationAxisY{};     ///< Sum of offset.y / |offset|^2 of the occupied neighbors.
+    std::vector<float> m_PopulationInvLocs{};   ///< 1 / in-bounds cells in the neighborhood.
+    std::vector<float> m_SignalSum{};           ///< Signal layer 0 sum in the neighborhood.
+    std::vector<float> m_SignalInvMax{};        ///< 1 / (in-bounds cells * SIGNAL_MAX).
+    std::vector<float> m_SignalAxisX{};         ///< Sum of offset.x / |offset|^2 of the in-bounds neighbors.
+    std::vector<float> m_SignalAxisY{};         ///< Sum of offset.y / |offset|^2 of the in-bounds neighbors.
+};
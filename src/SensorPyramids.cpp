@@ -0,0 +1,258 @@
+#include "SensorPyramids.h"
+
+#include "Genome.h"
+#include "Grid.h"
+#include "Parameters.h"
+#include "Peep.h"
+#include "PeepsPool.h"
+#include "PheromoneSignals.h"
+#include "SensorsActions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//-------------------------------------------------------------------------
+SensorPyramids::SensorPyramids(const Parameters& params)
+    : m_Params(params)
+{
+
+}
+
+//-------------------------------------------------------------------------
+bool SensorPyramids::Covers(float radius, const Parameters& params)
+{
+    return params.sensorPyramidRadius > 0.0f && radius >= params.sensorPyramidRadius;
+}
+
+//-------------------------------------------------------------------------
+unsigned SensorPyramids::LevelFor(float radius) const
+{
+    unsigned level = 0;
+    while (radius / (2 << level) >= cSamplesPerRadius &&
+           (m_Params.sizeX >> (level + 1)) > 0 && (m_Params.sizeY >> (level + 1)) > 0) {
+        ++level;
+    }
+    return level;
+}
+
+//-------------------------------------------------------------------------
+SensorPyramids::Pyramid SensorPyramids::MakePyramid(unsigned topLevel) const
+{
+    Pyramid pyramid(topLevel + 1);
+    for (unsigned levelNum = 0; levelNum <= topLevel; ++levelNum) {
+        Level& level = pyramid[levelNum];
+        const unsigned scale = 1u << levelNum;
+        level.sizeX = (m_Params.sizeX + scale - 1) / scale;
+        level.sizeY = (m_Params.sizeY + scale - 1) / scale;
+        level.cells.assign(level.sizeX * level.sizeY, 0.0f);
+    }
+    return pyramid;
+}
+
+//-------------------------------------------------------------------------
+template <typename F>
+void SensorPyramids::Build(Pyramid& pyramid, F&& read) const
+{
+    Level& base = pyramid[0];
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(static)
+    for (int16_t x = 0; x < base.sizeX; ++x) {
+        for (int16_t y = 0; y < base.sizeY; ++y) {
+            base.cells[x * base.sizeY + y] = read(Coord{x, y});
+        }
+    }
+
+    for (unsigned levelNum = 1; levelNum < pyramid.size(); ++levelNum) {
+        const Level& fine = pyramid[levelNum - 1];
+        Level& coarse = pyramid[levelNum];
+#pragma omp parallel for num_threads(m_Params.numThreads) schedule(static)
+        for (int x = 0; x < coarse.sizeX; ++x) {
+            const int x0 = 2 * x;
+            const int x1 = std::min(x0 + 1, fine.sizeX - 1);
+            for (int y = 0; y < coarse.sizeY; ++y) {
+                const int y0 = 2 * y;
+                const int y1 = std::min(y0 + 1, fine.sizeY - 1);
+                // Odd sized levels have half blocks at the end, those must not be counted twice.
+                float sum = fine(x0, y0);
+                sum += y1 != y0 ? fine(x0, y1) : 0.0f;
+                sum += x1 != x0 ? fine(x1, y0) : 0.0f;
+                sum += x1 != x0 && y1 != y0 ? fine(x1, y1) : 0.0f;
+                coarse.cells[x * coarse.sizeY + y] = sum;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void SensorPyramids::Init()
+{
+    const bool population = Covers(m_Params.populationSensorRadius, m_Params);
+    const bool signals = Covers(m_Params.signalSensorRadius, m_Params) && m_Params.signalLayers > 0;
+    m_PopulationLevel = LevelFor(m_Params.populationSensorRadius);
+    m_SignalLevel = LevelFor(m_Params.signalSensorRadius);
+    if (!population && !signals) {
+        m_InBounds.clear();
+        m_Occupancy.clear();
+        m_Signals.clear();
+        m_OccupancyActive = false;
+        m_SignalActive.clear();
+        return;
+    }
+
+    const unsigned topLevel = std::max(population ? m_PopulationLevel : 0, signals ? m_SignalLevel : 0);
+    m_Occupancy = population ? MakePyramid(m_PopulationLevel) : Pyramid{};
+    m_Signals.assign(signals ? m_Params.signalLayers : 0, MakePyramid(m_SignalLevel));
+    m_OccupancyActive = population;
+    m_SignalActive.assign(m_Signals.size(), true);
+    m_InBounds = MakePyramid(topLevel);
+    Build(m_InBounds, [](Coord) { return 1.0f; });
+}
+
+//-------------------------------------------------------------------------
+void SensorPyramids::SelectPyramids(const PeepsPool& peeps, const Sensors& sensors)
+{
+    m_OccupancyActive = false;
+    std::fill(m_SignalActive.begin(), m_SignalActive.end(), false);
+    if (!CoversPopulation() && !CoversSignals()) {
+        return;
+    }
+    // The axis signal sensors only read m_InBounds, their layer enters through the center cell.
+    const auto& types = sensors.AvailableTypes();
+    for (unsigned index = 1; index <= m_Params.population; ++index) {
+        for (const auto& conn : peeps[index].nnet.connections) {
+            if (conn.sourceType != Genetics::SENSOR || conn.sourceNum >= types.size()) {
+                continue;
+            }
+            const Sensors::eType type = types[conn.sourceNum];
+            switch (type) {
+            case Sensors::eType::POPULATION:
+            case Sensors::eType::POPULATION_FWD:
+            case Sensors::eType::POPULATION_LR:
+                m_OccupancyActive = CoversPopulation();
+                break;
+            case Sensors::eType::SIGNAL0:
+            case Sensors::eType::SIGNAL1:
+            case Sensors::eType::SIGNAL2:
+            case Sensors::eType::SIGNAL3:
+                if (SensorsActions::signalLayerOf(type) < m_SignalActive.size()) {
+                    m_SignalActive[SensorsActions::signalLayerOf(type)] = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void SensorPyramids::Update(const Grid& grid, const PheromoneSignals& pheromoneSignals)
+{
+    if (m_OccupancyActive) {
+        Build(m_Occupancy, [&grid](Coord loc) {
+            return grid.isOccupiedAt(loc) ? 1.0f : 0.0f;
+        });
+    }
+    for (unsigned layerNum = 0; layerNum < m_Signals.size(); ++layerNum) {
+        if (!m_SignalActive[layerNum]) {
+            continue;
+        }
+        Build(m_Signals[layerNum], [&pheromoneSignals, layerNum](Coord loc) {
+            return (float)pheromoneSignals.getMagnitude(layerNum, loc);
+        });
+    }
+}
+
+//-------------------------------------------------------------------------
+template <typename F>
+void SensorPyramids::VisitDisc(const Level& level, unsigned levelNum, Coord loc, float radius, F&& f) const
+{
+    const int scale = 1 << levelNum;
+    const float blockCenter = (scale - 1) * 0.5f;
+    const int x0 = std::max<int>(0, std::floor((loc.x - radius) / scale));
+    const int x1 = std::min<int>(level.sizeX - 1, std::floor((loc.x + radius) / scale));
+    const int y0 = std::max<int>(0, std::floor((loc.y - radius) / scale));
+    const int y1 = std::min<int>(level.sizeY - 1, std::floor((loc.y + radius) / scale));
+
+    for (int x = x0; x <= x1; ++x) {
+        const float offsetX = x * scale + blockCenter - loc.x;
+        for (int y = y0; y <= y1; ++y) {
+            const float offsetY = y * scale + blockCenter - loc.y;
+            if (offsetX * offsetX + offsetY * offsetY <= radius * radius) {
+                f(x * level.sizeY + y, offsetX, offsetY);
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+float SensorPyramids::SumAlongAxis(const Pyramid& pyramid, unsigned levelNum, Coord loc, Dir dir, float radius) const
+{
+    assert(dir != Compass::CENTER); // require a defined axis
+
+    Coord dirVec = dir.asNormalizedCoord();
+    float len = std::sqrt(dirVec.x * dirVec.x + dirVec.y * dirVec.y);
+    float dirVecX = dirVec.x / len;
+    float dirVecY = dirVec.y / len; // Unit vector components along dir
+
+    const Level& level = pyramid[levelNum];
+    const float minDistSq = levelNum > 0 ? float(1 << levelNum) * (1 << levelNum) : 1.0f;
+    float sum = 0.0f;
+    VisitDisc(level, levelNum, loc, radius, [&](size_t index, float offsetX, float offsetY) {
+        float proj = dirVecX * offsetX + dirVecY * offsetY; // Magnitude of projection along dir
+        sum += level.cells[index] * proj / std::max(offsetX * offsetX + offsetY * offsetY, minDistSq);
+    });
+    return sum;
+}
+
+//-------------------------------------------------------------------------
+float SensorPyramids::GetPopulationDensity(Coord loc) const
+{
+    assert(CoversPopulation());
+    const Level& occupancy = m_Occupancy[m_PopulationLevel];
+    const Level& inBounds = m_InBounds[m_PopulationLevel];
+    float countOccupied = 0.0f;
+    float countLocs = 0.0f;
+    VisitDisc(occupancy, m_PopulationLevel, loc, m_Params.populationSensorRadius, [&](size_t index, float, float) {
+        countOccupied += occupancy.cells[index];
+        countLocs += inBounds.cells[index];
+    });
+    return countLocs > 0.0f ? countOccupied / countLocs : 0.0f;
+}
+
+//-------------------------------------------------------------------------
+float SensorPyramids::GetPopulationDensityAlongAxis(Coord loc, Dir dir) const
+{
+    assert(CoversPopulation());
+    double sum = SumAlongAxis(m_Occupancy, m_PopulationLevel, loc, dir, m_Params.populationSensorRadius);
+
+    double maxSumMag = 6.0 * m_Params.populationSensorRadius;
+    double sensorVal = std::clamp(sum / maxSumMag, -1.0, 1.0); // convert to -1.0..1.0
+    return (sensorVal + 1.0) / 2.0; // convert to 0.0..1.0
+}
+
+//-------------------------------------------------------------------------
+float SensorPyramids::GetSignalDensity(unsigned layerNum, Coord loc) const
+{
+    assert(layerNum < m_Signals.size());
+    const Level& signal = m_Signals[layerNum][m_SignalLevel];
+    const Level& inBounds = m_InBounds[m_SignalLevel];
+    float sum = 0.0f;
+    float countLocs = 0.0f;
+    VisitDisc(signal, m_SignalLevel, loc, m_Params.signalSensorRadius, [&](size_t index, float, float) {
+        sum += signal.cells[index];
+        countLocs += inBounds.cells[index];
+    });
+    return countLocs > 0.0f ? sum / (countLocs * SIGNAL_MAX) : 0.0f;
+}
+
+//-------------------------------------------------------------------------
+float SensorPyramids::GetSignalDensityAlongAxis(Coord loc, Dir dir, uint8_t centerMagnitude) const
+{
+    assert(CoversSignals());
+    double sum = centerMagnitude * SumAlongAxis(m_InBounds, m_SignalLevel, loc, dir, m_Params.signalSensorRadius);
+
+    double maxSumMag = 6.0 * m_Params.signalSensorRadius * SIGNAL_MAX;
+    double sensorVal = std::clamp(sum / maxSumMag, -1.0, 1.0); // convert to -1.0..1.0
+    return (sensorVal + 1.0) / 2.0; // convert to 0.0..1.0
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+class Grid;
+class Parameters;
+class PeepsPool;
+class PheromoneSignals;
+class Sensors;
+
+/*! \class SensorPyramids
+    \brief Multi-resolution occupancy and pheromone pyramids for long-radius sensing.
+
+    The neighborhood sensors visit every cell of a disc, so their cost grows with the
+    square of populationSensorRadius and signalSensorRadius. For radii at or above
+    sensorPyramidRadius this class answers the same queries from mip-mapped copies of
+    the occupancy grid and the signal layers instead. Level k stores the sums of
+    2^k x 2^k blocks of level 0. A query of radius r is served from the level where
+    the disc is still at least cSamplesPerRadius blocks wide in each direction, so it
+    visits about pi * cSamplesPerRadius^2 blocks independently of r.
+
+    Approximation error:
+        - A block is taken fully or not at all, depending on whether its center lies in
+          the disc. Density sensors normalize with the in-bounds cell count of the same
+          blocks, so only the density difference between the disc edge and the
+          included or excluded edge blocks leaks into the result. The error is bounded
+          by the edge blocks' share of the disc, about 2 / cSamplesPerRadius in the worst
+          case and a few percent for smooth densities.
+        - Directional sensors weight each block with the offset of its center. The
+          block the peep stands in is weighted as if it was one block away, otherwise
+          its own contribution, which cancels out in the exact sum, would dominate.
+        - Level 0 gives the same result as the direct neighborhood walk.
+
+    The pyramids are rebuilt in every sim step. The signals fade in every step, so an
+    incremental update would touch every cell anyway. Pyramids no wired net reads are
+    skipped, see SelectPyramids().
+*/
+class SensorPyramids
+{
+public:
+    //! Number of blocks covering a radius at the level chosen for a query.
+    static constexpr float cSamplesPerRadius = 4.0f;
+
+    SensorPyramids(const Parameters& params);
+
+    //! Returns true if neighborhood queries of the given radius use the pyramids.
+    static bool Covers(float radius, const Parameters& params);
+
+    //! Allocates the levels needed by the sensor radii. Has to be called after the
+    //! parameters are read.
+    void Init();
+    //! Selects the pyramids read by the currently wired nets, all are selected after Init().
+    //! Called once a new generation has been spawned.
+    void SelectPyramids(const PeepsPool& peeps, const Sensors& sensors);
+    //! Rebuilds the selected pyramids. Called in single-thread mode before the peeps are stepped.
+    void Update(const Grid& grid, const PheromoneSignals& pheromoneSignals);
+    //! Returns true if the population sensors are served by the pyramids.
+    bool CoversPopulation() const { return !m_Occupancy.empty(); }
+    //! Returns true if the signal sensors are served by the pyramids.
+    bool CoversSignals() const { return !m_Signals.empty(); }
+
+    //! Approximates the POPULATION sensor. Returns 0.0..1.0.
+    float GetPopulationDensity(Coord loc) const;
+    //! Approximates AlgorithmHelpers::getPopulationDensityAlongAxis(). Returns 0.0..1.0.
+    float GetPopulationDensityAlongAxis(Coord loc, Dir dir) const;
+    //! Approximates SensorsActions::getSignalDensity(). Returns 0.0..1.0.
+    float GetSignalDensity(unsigned layerNum, Coord loc) const;
+    //! Approximates SensorsActions::getSignalDensityAlongAxis(). That sensor weights its
+    //! neighborhood with the magnitude of the center cell, hence the caller passes it in.
+    //! Returns 0.0..1.0.
+    float GetSignalDensityAlongAxis(Coord loc, Dir dir, uint8_t centerMagnitude) const;
+
+private:
+    //! Block sums of one resolution, column major.
+    struct Level {
+        uint16_t sizeX{};
+        uint16_t sizeY{};
+        std::vector<float> cells{};
+        float operator()(int x, int y) const { return cells[x * sizeY + y]; }
+    };
+    using Pyramid = std::vector<Level>;
+
+    //! Returns the coarsest level that still has cSamplesPerRadius blocks per radius.
+    unsigned LevelFor(float radius) const;
+    //! Allocates levels 0..topLevel.
+    Pyramid MakePyramid(unsigned topLevel) const;
+    //! Fills level 0 from \a read and sums the levels above it.
+    template <typename F>
+    void Build(Pyramid& pyramid, F&& read) const;
+    //! Calls f(blockValueIndex, offsetX, offsetY) for each block of \a level whose center
+    //! lies within \a radius of \a loc. The offsets are in level 0 cells.
+    template <typename F>
+    void VisitDisc(const Level& level, unsigned levelNum, Coord loc, float radius, F&& f) const;
+    //! Sum of value * (offset . axis) / |offset|^2 over the disc.
+    float SumAlongAxis(const Pyramid& pyramid, unsigned levelNum, Coord loc, Dir dir, float radius) const;
+
+    const Parameters& m_Params;
+    unsigned m_PopulationLevel{};       ///< Level serving populationSensorRadius.
+    unsigned m_SignalLevel{};           ///< Level serving signalSensorRadius.
+    Pyramid m_InBounds{};               ///< 1.0 for every cell of the world.
+    Pyramid m_Occupancy{};              ///< 1.0 where a peep lives. Empty if not covered.
+    std::vector<Pyramid> m_Signals{};   ///< One per signal layer. Empty if not covered.
+    bool m_OccupancyActive{};           ///< m_Occupancy is rebuilt each step.
+    std::vector<bool> m_SignalActive{}; ///< Per signal layer, the pyramid is rebuilt each step.
+};
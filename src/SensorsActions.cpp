@@ -7,11 +7,17 @@
 #include "PeepsPool.h"
 #include "PheromoneSignals.h"
 #include "Random.h"
+#include "SensorFields.h"
+#include "SensorPyramids.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits.h>
 #include <iostream>
 
+static_assert(Sensors::eType::SIGNAL3_LR + 1 - Sensors::eType::SIGNAL0 == 3 * SIGNAL_LAYERS_MAX);
+static_assert(Actions::eType::EMIT_SIGNAL3 + 1 - Actions::eType::EMIT_SIGNAL0 == SIGNAL_LAYERS_MAX);
+
 namespace SensorsActions
 {
 
@@ -39,6 +45,15 @@ std::string sensorName(Sensors::eType sensor)
     case Sensors::eType::SIGNAL0: return "signal 0"; break;
     case Sensors::eType::SIGNAL0_FWD: return "signal 0 fwd"; break;
     case Sensors::eType::SIGNAL0_LR: return "signal 0 LR"; break;
+    case Sensors::eType::SIGNAL1: return "signal 1"; break;
+    case Sensors::eType::SIGNAL1_FWD: return "signal 1 fwd"; break;
+    case Sensors::eType::SIGNAL1_LR: return "signal 1 LR"; break;
+    case Sensors::eType::SIGNAL2: return "signal 2"; break;
+    case Sensors::eType::SIGNAL2_FWD: return "signal 2 fwd"; break;
+    case Sensors::eType::SIGNAL2_LR: return "signal 2 LR"; break;
+    case Sensors::eType::SIGNAL3: return "signal 3"; break;
+    case Sensors::eType::SIGNAL3_FWD: return "signal 3 fwd"; break;
+    case Sensors::eType::SIGNAL3_LR: return "signal 3 LR"; break;
     case Sensors::eType::GENETIC_SIM_FWD: return "genetic similarity fwd"; break;
     case Sensors::eType::PlannedLocX: return "planned loc x diff"; break;
     case Sensors::eType::PlannedLocY: return "planned loc y diff"; break;
@@ -73,6 +88,15 @@ std::string sensorShortName(Sensors::eType sensor)
     case Sensors::eType::SIGNAL0: return "Sg"; break;
     case Sensors::eType::SIGNAL0_FWD: return "Sfd"; break;
     case Sensors::eType::SIGNAL0_LR: return "Slr"; break;
+    case Sensors::eType::SIGNAL1: return "Sg1"; break;
+    case Sensors::eType::SIGNAL1_FWD: return "Sf1"; break;
+    case Sensors::eType::SIGNAL1_LR: return "Sl1"; break;
+    case Sensors::eType::SIGNAL2: return "Sg2"; break;
+    case Sensors::eType::SIGNAL2_FWD: return "Sf2"; break;
+    case Sensors::eType::SIGNAL2_LR: return "Sl2"; break;
+    case Sensors::eType::SIGNAL3: return "Sg3"; break;
+    case Sensors::eType::SIGNAL3_FWD: return "Sf3"; break;
+    case Sensors::eType::SIGNAL3_LR: return "Sl3"; break;
     case Sensors::eType::GENETIC_SIM_FWD: return "Gen"; break;
     case Sensors::eType::PlannedLocX: return "PXd"; break;
     case Sensors::eType::PlannedLocY: return "PYd"; break;
@@ -98,6 +122,9 @@ std::string actionShortName(Actions::eType action)
     case Actions::eType::SET_RESPONSIVENESS: return "Res"; break;
     case Actions::eType::SET_OSCILLATOR_PERIOD: return "OSC"; break;
     case Actions::eType::EMIT_SIGNAL0: return "SG"; break;
+    case Actions::eType::EMIT_SIGNAL1: return "SG1"; break;
+    case Actions::eType::EMIT_SIGNAL2: return "SG2"; break;
+    case Actions::eType::EMIT_SIGNAL3: return "SG3"; break;
     case Actions::eType::KILL_FORWARD: return "Klf"; break;
     case Actions::eType::MOVE_RANDOM: return "Mrn"; break;
     case Actions::eType::SET_LONGPROBE_DIST: return "LPD"; break;
@@ -122,6 +149,9 @@ std::string actionName(Actions::eType action)
     case Actions::eType::SET_RESPONSIVENESS: return "set inv-responsiveness"; break;
     case Actions::eType::SET_OSCILLATOR_PERIOD: return "set osc1"; break;
     case Actions::eType::EMIT_SIGNAL0: return "emit signal 0"; break;
+    case Actions::eType::EMIT_SIGNAL1: return "emit signal 1"; break;
+    case Actions::eType::EMIT_SIGNAL2: return "emit signal 2"; break;
+    case Actions::eType::EMIT_SIGNAL3: return "emit signal 3"; break;
     case Actions::eType::KILL_FORWARD: return "kill fwd"; break;
     case Actions::eType::MOVE_NW: return "move north west"; break;
     case Actions::eType::MOVE_RANDOM: return "move random"; break;
@@ -329,6 +359,14 @@ float Sensors::getSensor(
     {
         // Returns population density in neighborhood converted linearly from
         // 0..100% to sensor range
+        if (m_pPyramids && m_pPyramids->CoversPopulation()) {
+            sensorVal = m_pPyramids->GetPopulationDensity(peep.loc);
+            break;
+        }
+        if (m_pFields && m_pFields->IsActive(SensorFields::eField::Population)) {
+            sensorVal = m_pFields->GetPopulationDensity(peep.loc);
+            break;
+        }
         unsigned countLocs = 0;
         unsigned countOccupied = 0;
         Coord center = peep.loc;
@@ -347,10 +385,26 @@ float Sensors::getSensor(
     case eType::POPULATION_FWD:
         // Sense population density along axis of last movement direction, mapped
         // to sensor range 0.0..1.0
+        if (m_pPyramids && m_pPyramids->CoversPopulation()) {
+            sensorVal = m_pPyramids->GetPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir);
+            break;
+        }
+        if (m_pFields && m_pFields->IsActive(SensorFields::eField::PopulationAxis)) {
+            sensorVal = m_pFields->GetPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir);
+            break;
+        }
         sensorVal = AlgorithmHelpers::getPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir, grid, params);
         break;
     case eType::POPULATION_LR:
         // Sense population density along an axis 90 degrees from last movement direction
+        if (m_pPyramids && m_pPyramids->CoversPopulation()) {
+            sensorVal = m_pPyramids->GetPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir.rotate90DegCW());
+            break;
+        }
+        if (m_pFields && m_pFields->IsActive(SensorFields::eField::PopulationAxis)) {
+            sensorVal = m_pFields->GetPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir.rotate90DegCW());
+            break;
+        }
         sensorVal = AlgorithmHelpers::getPopulationDensityAlongAxis(peep.loc, peep.lastMoveDir.rotate90DegCW(), grid, params);
         break;
     case eType::BARRIER_FWD:
@@ -365,30 +419,71 @@ float Sensors::getSensor(
         break;
     case eType::RANDOM:
         // Returns a random sensor value in the range 0.0..1.0.
-        sensorVal = random() / (float)UINT_MAX;
+        sensorVal = random.uniform();
         break;
     case eType::SIGNAL0:
-        // Returns magnitude of signal0 in the local neighborhood, with
+    case eType::SIGNAL1:
+    case eType::SIGNAL2:
+    case eType::SIGNAL3:
+    {
+        // Returns magnitude of the signal layer in the local neighborhood, with
         // 0.0..maxSignalSum converted to sensorRange 0.0..1.0
-        sensorVal = SensorsActions::getSignalDensity(0, peep.loc, pheromoneSignals, params);
+        const unsigned layerNum = SensorsActions::signalLayerOf(sensorType);
+        if (layerNum >= pheromoneSignals.layerCount()) {
+            break;
+        }
+        if (m_pPyramids && m_pPyramids->CoversSignals()) {
+            sensorVal = m_pPyramids->GetSignalDensity(layerNum, peep.loc);
+            break;
+        }
+        if (layerNum == 0 && m_pFields && m_pFields->IsActive(SensorFields::eField::Signal0)) {
+            sensorVal = m_pFields->GetSignalDensity(peep.loc);
+            break;
+        }
+        sensorVal = SensorsActions::getSignalDensity(layerNum, peep.loc, pheromoneSignals, params);
         break;
+    }
     case eType::SIGNAL0_FWD:
-        // Sense signal0 density along axis of last movement direction
-        sensorVal = SensorsActions::getSignalDensityAlongAxis(0, peep.loc, peep.lastMoveDir, pheromoneSignals, params);
-        break;
     case eType::SIGNAL0_LR:
-        // Sense signal0 density along an axis perpendicular to last movement direction
-        sensorVal = SensorsActions::getSignalDensityAlongAxis(0, peep.loc, peep.lastMoveDir.rotate90DegCW(), pheromoneSignals, params);
+    case eType::SIGNAL1_FWD:
+    case eType::SIGNAL1_LR:
+    case eType::SIGNAL2_FWD:
+    case eType::SIGNAL2_LR:
+    case eType::SIGNAL3_FWD:
+    case eType::SIGNAL3_LR:
+    {
+        // Sense the signal layer density along axis of last movement direction (FWD)
+        // or along an axis perpendicular to it (LR)
+        const unsigned layerNum = SensorsActions::signalLayerOf(sensorType);
+        if (layerNum >= pheromoneSignals.layerCount()) {
+            break;
+        }
+        const bool forward = (sensorType - eType::SIGNAL0) % 3 == 1;
+        const Dir dir = forward ? peep.lastMoveDir : peep.lastMoveDir.rotate90DegCW();
+        // The axis weights only depend on the geometry, the layer enters through the center magnitude.
+        if (m_pPyramids && m_pPyramids->CoversSignals()) {
+            sensorVal = m_pPyramids->GetSignalDensityAlongAxis(peep.loc, dir, pheromoneSignals.getMagnitude(layerNum, peep.loc));
+            break;
+        }
+        if (m_pFields && m_pFields->IsActive(SensorFields::eField::Signal0Axis)) {
+            sensorVal = m_pFields->GetSignalDensityAlongAxis(peep.loc, dir, pheromoneSignals.getMagnitude(layerNum, peep.loc));
+            break;
+        }
+        sensorVal = SensorsActions::getSignalDensityAlongAxis(layerNum, peep.loc, dir, pheromoneSignals, params);
         break;
+    }
     case eType::GENETIC_SIM_FWD:
     {
         // Return minimum sensor value if nobody is alive in the forward adjacent location,
-        // else returns a similarity match in the sensor range 0.0..1.0
+        // else returns a similarity match in the sensor range 0.0..1.0. The sketches are
+        // compared unless the exact comparison is configured.
         Coord loc2 = peep.loc + peep.lastMoveDir;
         if (grid.isInBounds(loc2) && grid.isOccupiedAt(loc2)) {
             const Peep &peep2 = peeps.getPeep(loc2);
             if (peep2.alive) {
-                sensorVal = Genetics::genomeSimilarity(peep.genome, peep2.genome, params); // 0.0..1.0
+                sensorVal = params.exactGeneticSimilarity
+                    ? Genetics::genomeSimilarity(peep.genome, peep2.genome, params)
+                    : Genetics::sketchSimilarity(peep.sketch, peep2.sketch); // 0.0..1.0
             }
         }
         break;
@@ -443,6 +538,36 @@ float Sensors::getSensor(
     return sensorVal;
 }
 
+//-------------------------------------------------------------------------
+void Sensors::PrepareGeneticSimilarity(PeepsPool& peeps, const Parameters& params) const
+{
+    if (params.exactGeneticSimilarity) {
+        return;
+    }
+    const auto sensor = std::find(m_AvailableTypes.begin(), m_AvailableTypes.end(), eType::GENETIC_SIM_FWD);
+    if (sensor == m_AvailableTypes.end()) {
+        return;
+    }
+    const unsigned sensorNum = sensor - m_AvailableTypes.begin();
+    const std::vector<PeepIndex>& livePeeps = peeps.livePeeps();
+    const bool used = std::any_of(livePeeps.begin(), livePeeps.end(), [&](PeepIndex index) {
+        const auto& connections = peeps[index].nnet.connections;
+        return std::any_of(connections.begin(), connections.end(), [&](const Genetics::Gene& conn) {
+            return conn.sourceType == Genetics::SENSOR && conn.sourceNum == sensorNum;
+        });
+    });
+    if (!used) {
+        return;
+    }
+
+    const int64_t liveCount = livePeeps.size();
+#pragma omp parallel for num_threads(params.numThreads) schedule(dynamic, 64)
+    for (int64_t n = 0; n < liveCount; ++n) {
+        Peep& peep = peeps[livePeeps[n]];
+        peep.sketch = Genetics::makeGenomeSketch(peep.genome);
+    }
+}
+
 //---------------------------------------------------------------------------
 Actions::Actions(
     PeepsPool& peepsPool,
@@ -521,18 +646,22 @@ void Actions::executeActions(Peep &peep, unsigned simStep, std::array<float, eTy
                 peep.longProbeDist = (unsigned)level;
                 break;
             }
-            // Emit signal0 - if this action value is below a threshold, nothing emitted.
+            // Emit signalN - if this action value is below a threshold, nothing emitted.
             // Otherwise convert the action value to a probability of emitting one unit of
-            // signal (pheromone).
+            // signal (pheromone) into layer N.
             // Pheromones may be emitted immediately (see signals.cpp). If this action neuron
             // is enabled but not driven, nothing will be emitted.
             case Actions::eType::EMIT_SIGNAL0:
+            case Actions::eType::EMIT_SIGNAL1:
+            case Actions::eType::EMIT_SIGNAL2:
+            case Actions::eType::EMIT_SIGNAL3:
             {
                 constexpr float emitThreshold = 0.5;  // 0.0..1.0; 0.5 is midlevel
+                const unsigned layerNum = SensorsActions::signalLayerOf(type);
                 level = (std::tanh(level) + 1.0) / 2.0; // convert to 0.0..1.0
                 level *= responsivenessAdjusted;
-                if (level > emitThreshold && AlgorithmHelpers::prob2bool(level, m_Random)) {
-                    m_Signals.increment(0, peep.loc);
+                if (level > emitThreshold && AlgorithmHelpers::prob2bool(level, m_Random) && layerNum < m_Signals.layerCount()) {
+                    m_Signals.increment(layerNum, peep.loc);
                 }
                 break;
             }
@@ -12,6 +12,8 @@ class Peep;
 class PeepsPool;
 class PheromoneSignals;
 class RandomUintGenerator;
+class SensorFields;
+class SensorPyramids;
 
 class Sensors
 {
@@ -44,6 +46,15 @@ public:
         SIGNAL0,            // W strength of signal0 in neighborhood
         SIGNAL0_FWD,        // W strength of signal0 in the forward-reverse axis
         SIGNAL0_LR,         // W strength of signal0 in the left-right axis
+        SIGNAL1,            // W the same trio for the signal layers 1..SIGNAL_LAYERS_MAX - 1,
+        SIGNAL1_FWD,        //   it has to stay in the SIGNAL0, SIGNAL0_FWD, SIGNAL0_LR order
+        SIGNAL1_LR,
+        SIGNAL2,
+        SIGNAL2_FWD,
+        SIGNAL2_LR,
+        SIGNAL3,
+        SIGNAL3_FWD,
+        SIGNAL3_LR,
         PlannedLocX,        // I reads the difference between current and planned loc x
         PlannedLocY,        // I reads the difference between current and planned loc y
         PlannedLocTime,     // I reads the difference between the current and planned sim step
@@ -56,6 +67,20 @@ public:
     void UpdateAvailableSensorTypes(const std::vector<eType>& types) { m_AvailableTypes = types; }
     //! Returns the available sensor type count.
     unsigned AvailableSensorTypeCount() const { return m_AvailableTypes.size(); }
+    //! Returns the available sensor types.
+    const std::vector<eType>& AvailableTypes() const { return m_AvailableTypes; }
+    //! Sets the precomputed fields the neighborhood sensors sample when they are active.
+    //! nullptr disables it.
+    void UseSensorFields(const SensorFields* pFields) { m_pFields = pFields; }
+    //! Sets the pyramids the long-radius neighborhood sensors sample. They take
+    //! precedence over the sensor fields. nullptr disables it.
+    void UseSensorPyramids(const SensorPyramids* pPyramids) { m_pPyramids = pPyramids; }
+
+    //! Computes the genome sketches of the living peeps that GENETIC_SIM_FWD compares,
+    //! if any net reads the sensor and Parameters::exactGeneticSimilarity is not set.
+    //! Called in single-thread mode at the start of a generation, the genomes don't
+    //! change before the next.
+    void PrepareGeneticSimilarity(PeepsPool& peeps, const Parameters& params) const;
 
     //! Returned sensor values range SENSOR_MIN..SENSOR_MAX.
     float getSensor(    
@@ -71,6 +96,8 @@ public:
 
 private:
     std::vector<eType> m_AvailableTypes{};         ///!< Contains the available sensors types.
+    const SensorFields* m_pFields{nullptr};        ///!< Precomputed neighborhood sensor fields.
+    const SensorPyramids* m_pPyramids{nullptr};    ///!< Pyramids of the long-radius sensors.
 };
 
 class Actions
@@ -84,6 +111,9 @@ public:
         SET_LONGPROBE_DIST,       // I
         SET_RESPONSIVENESS,       // I
         EMIT_SIGNAL0,             // W
+        EMIT_SIGNAL1,             // W consecutive, one for each signal layer
+        EMIT_SIGNAL2,             // W
+        EMIT_SIGNAL3,             // W
         PlanPosX,                 // I
         PlanPosY,                 // I
         PlanTime,                 // I
@@ -176,6 +206,11 @@ constexpr float ACTION_MIN = 0.0;
 constexpr float ACTION_MAX = 1.0;
 constexpr float ACTION_RANGE = ACTION_MAX - ACTION_MIN;
 
+//! Returns the signal layer a SIGNALn, SIGNALn_FWD or SIGNALn_LR sensor reads.
+inline unsigned signalLayerOf(Sensors::eType sensor) { return (sensor - Sensors::eType::SIGNAL0) / 3; }
+//! Returns the signal layer an EMIT_SIGNALn action writes.
+inline unsigned signalLayerOf(Actions::eType action) { return action - Actions::eType::EMIT_SIGNAL0; }
+
 //! returns magnitude of the specified signal layer in a neighborhood, with
 //! 0.0..maxSignalSum converted to the sensor range.
 float getSignalDensity(unsigned layerNum, Coord loc, const PheromoneSignals& pheromoneSignals, const Parameters& params);
@@ -0,0 +1,77 @@
+#include "SpatialOrder.h"
+
+#include "Parameters.h"
+#include "PeepsPool.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <utility>
+
+//-------------------------------------------------------------------------
+SpatialOrder::SpatialOrder(const Parameters& params)
+    : m_Params(params)
+{
+
+}
+
+//-------------------------------------------------------------------------
+uint32_t SpatialOrder::HilbertKey(Coord loc, unsigned curveOrder)
+{
+    uint32_t x = loc.x;
+    uint32_t y = loc.y;
+    uint32_t key = 0;
+    for (uint32_t s = (1u << curveOrder) >> 1; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        key += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve stays continuous.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return key;
+}
+
+//-------------------------------------------------------------------------
+void SpatialOrder::Update(PeepsPool& peeps, unsigned simStep)
+{
+    if (m_Params.spatialOrderStride == 0 || simStep % m_Params.spatialOrderStride != 0) {
+        return;
+    }
+    m_CurveOrder = 0;
+    while ((1u << m_CurveOrder) < std::max(m_Params.sizeX, m_Params.sizeY)) {
+        ++m_CurveOrder;
+    }
+
+    const std::vector<PeepIndex>& livePeeps = peeps.livePeeps();
+    m_Order.assign(livePeeps.begin(), livePeeps.end());
+    m_Keys.resize(m_Order.size());
+    for (size_t i = 0; i < m_Order.size(); ++i) {
+        m_Keys[i] = HilbertKey(peeps[m_Order[i]].loc, m_CurveOrder);
+    }
+
+    // LSD radix sort of the (key, index) pairs, only over the bytes the keys use.
+    m_ScratchOrder.resize(m_Order.size());
+    m_ScratchKeys.resize(m_Keys.size());
+    const unsigned keyBits = 2 * m_CurveOrder;
+    for (unsigned shift = 0; shift < keyBits; shift += 8) {
+        std::array<size_t, 257> offsets{};
+        for (uint32_t key : m_Keys) {
+            ++offsets[((key >> shift) & 0xff) + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (size_t i = 0; i < m_Keys.size(); ++i) {
+            size_t dst = offsets[(m_Keys[i] >> shift) & 0xff]++;
+            m_ScratchKeys[dst] = m_Keys[i];
+            m_ScratchOrder[dst] = m_Order[i];
+        }
+        m_Keys.swap(m_ScratchKeys);
+        m_Order.swap(m_ScratchOrder);
+    }
+    peeps.reorderLivePeeps(m_Order);
+}
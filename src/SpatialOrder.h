@@ -0,0 +1,44 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+class Parameters;
+class PeepsPool;
+
+/*! \class SpatialOrder
+    \brief Sorts the living peeps along a Hilbert curve of their locations.
+
+    After a few hundred sim steps the peep indexes have no relation to the grid
+    position, so stepping the peeps by index reads the grid and the signal layers at
+    scattered places. If Parameters::spatialOrderStride is set, the list of the living
+    peeps in PeepsPool is re-sorted by the Hilbert key of Peep::loc every
+    spatialOrderStride sim steps. Consecutive peeps of the list are then close to each
+    other, and a static schedule hands each thread a compact region of the world.
+
+    The peeps move at most one cell per step, so the keys change little between two
+    refreshes. The refresh is a LSD radix sort, linear in the living peeps.
+    Without a stride the list keeps the order of PeepsPool.
+*/
+class SpatialOrder
+{
+public:
+    SpatialOrder(const Parameters& params);
+
+    //! Re-sorts the living peeps of \a peeps if it is due in this sim step. Called in
+    //! single-thread mode before the peeps are stepped.
+    void Update(PeepsPool& peeps, unsigned simStep);
+
+    //! Position of loc along the Hilbert curve filling a 2^curveOrder square.
+    static uint32_t HilbertKey(Coord loc, unsigned curveOrder);
+
+private:
+    const Parameters& m_Params;
+    unsigned m_CurveOrder{};                 ///< log2 of the side of the square covering the world.
+    std::vector<PeepIndex> m_Order{};        ///< The living peeps being sorted.
+    std::vector<uint32_t> m_Keys{};
+    std::vector<PeepIndex> m_ScratchOrder{}; ///< Radix sort buffers.
+    std::vector<uint32_t> m_ScratchKeys{};
+};
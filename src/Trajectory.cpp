@@ -0,0 +1,343 @@
+#include "Trajectory.h"
+
+#include "Genome.h"
+#include "Parameters.h"
+#include "PeepsPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    constexpr size_t cHeaderSize = 24;          ///< Without the colors.
+    constexpr size_t cFooterTailSize = 24;      ///< Without the keyframe index.
+    constexpr size_t cKeyframeEntrySize = 5;    ///< Bytes per peep in a keyframe.
+    constexpr size_t cIndexEntrySize = 12;
+    constexpr size_t cPlacementSize = 8;
+}
+
+//-------------------------------------------------------------------------
+TrajectoryRecorder::TrajectoryRecorder(const Parameters& params)
+    : m_Params(params)
+{
+
+}
+
+//-------------------------------------------------------------------------
+std::string TrajectoryRecorder::FilePath(const Parameters& params, unsigned generation)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "/gen-%06u.trj", generation);
+    return params.imageDir + name;
+}
+
+//-------------------------------------------------------------------------
+bool TrajectoryRecorder::IsRecording(unsigned generation) const
+{
+    return m_Params.saveTrajectories
+        && (generation % m_Params.videoStride == 0 || generation <= m_Params.videoSaveFirstFrames);
+}
+
+//-------------------------------------------------------------------------
+template <typename T>
+void TrajectoryRecorder::Append(const T& value)
+{
+    const auto* pBytes = reinterpret_cast<const uint8_t*>(&value);
+    m_Stream.insert(m_Stream.end(), pBytes, pBytes + sizeof(T));
+}
+
+//-------------------------------------------------------------------------
+void TrajectoryRecorder::BeginGeneration(unsigned generation, const PeepsPool& peeps)
+{
+    m_Recording = IsRecording(generation);
+    if (!m_Recording) {
+        return;
+    }
+    m_Generation = generation;
+    m_Step = 0;
+    m_Stream.clear();
+    m_Keyframes.clear();
+
+    const uint32_t population = m_Params.population;
+    m_Stream.insert(m_Stream.end(), {'G', 'O', 'E', 'V', 'T', 'R', 'J', '1'});
+    Append(m_Params.sizeX);
+    Append(m_Params.sizeY);
+    Append(uint32_t(generation));
+    Append(population);
+    Append(uint32_t(m_Params.trajectoryKeyframeStride));
+
+    m_Locations.assign(population + 1, Coord());
+    m_Alive.assign(population + 1, 0);
+    for (PeepIndex index = 1; index <= population; ++index) {
+        const Peep& peep = peeps[index];
+        Append(Genetics::makeGeneticColor(peep.genome));
+        m_Locations[index] = peep.loc;
+        m_Alive[index] = peep.alive;
+    }
+}
+
+//-------------------------------------------------------------------------
+void TrajectoryRecorder::AppendKeyframe()
+{
+    m_Keyframes.emplace_back(m_Step, m_Stream.size());
+    for (size_t index = 1; index < m_Locations.size(); ++index) {
+        Append(m_Alive[index]);
+        Append(int16_t(m_Locations[index].x));
+        Append(int16_t(m_Locations[index].y));
+    }
+}
+
+//-------------------------------------------------------------------------
+void TrajectoryRecorder::AddStep(const PeepsPool& peeps)
+{
+    if (!m_Recording) {
+        return;
+    }
+    if (m_Step % m_Params.trajectoryKeyframeStride == 0) {
+        AppendKeyframe();
+    }
+
+    uint8_t pending = 0;
+    bool highNibble = false;
+    auto appendNibble = [&](uint8_t code) {
+        if (highNibble) {
+            m_Stream.push_back(pending | (code << 4));
+        } else {
+            pending = code;
+        }
+        highNibble = !highNibble;
+    };
+    uint32_t placementCount = 0;
+    m_Placements.clear();
+    auto appendPlacement = [&](uint32_t index, Coord loc) {
+        uint8_t bytes[cPlacementSize];
+        const int16_t x = loc.x;
+        const int16_t y = loc.y;
+        std::memcpy(&bytes[0], &index, sizeof(index));
+        std::memcpy(&bytes[4], &x, sizeof(x));
+        std::memcpy(&bytes[6], &y, sizeof(y));
+        m_Placements.insert(m_Placements.end(), std::begin(bytes), std::end(bytes));
+        ++placementCount;
+    };
+
+    for (size_t index = 1; index < m_Locations.size(); ++index) {
+        const Peep& peep = peeps[index];
+        if (m_Alive[index]) {
+            const int dx = peep.loc.x - m_Locations[index].x;
+            const int dy = peep.loc.y - m_Locations[index].y;
+            if (!peep.alive) {
+                appendNibble(Trajectory::cDied);
+            } else if (std::abs(dx) <= 1 && std::abs(dy) <= 1) {
+                appendNibble((dx + 1) * 3 + (dy + 1));
+            } else {
+                appendNibble(Trajectory::cPlaced);
+                appendPlacement(index, peep.loc);
+            }
+        } else if (peep.alive) {
+            appendPlacement(index, peep.loc);
+        }
+        m_Locations[index] = peep.loc;
+        m_Alive[index] = peep.alive;
+    }
+    if (highNibble) {
+        m_Stream.push_back(pending);
+    }
+    Append(placementCount);
+    m_Stream.insert(m_Stream.end(), m_Placements.begin(), m_Placements.end());
+    ++m_Step;
+}
+
+//-------------------------------------------------------------------------
+void TrajectoryRecorder::EndGeneration()
+{
+    if (!m_Recording) {
+        return;
+    }
+    m_Recording = false;
+
+    // Every state 0..m_Step is reachable from a keyframe at or before it.
+    if (m_Step % m_Params.trajectoryKeyframeStride == 0) {
+        AppendKeyframe();
+    }
+    const uint64_t footerOffset = m_Stream.size();
+    for (const auto& keyframe : m_Keyframes) {
+        Append(keyframe.first);
+        Append(keyframe.second);
+    }
+    Append(uint32_t(m_Step));
+    Append(uint32_t(m_Keyframes.size()));
+    Append(footerOffset);
+    m_Stream.insert(m_Stream.end(), {'G', 'O', 'E', 'V', 'T', 'R', 'J', 'E'});
+
+    const std::string path = FilePath(m_Params, m_Generation);
+    std::error_code error;
+    std::filesystem::create_directories(m_Params.imageDir, error);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(m_Stream.data()), m_Stream.size());
+    if (!file) {
+        std::cerr << "Couldn't write trajectory " << path << "." << std::endl;
+        return;
+    }
+    std::cout << "Saved " << m_Step << " steps of generation " << m_Generation
+              << " to " << path << ", " << m_Stream.size() << " bytes." << std::endl;
+}
+
+//-------------------------------------------------------------------------
+template <typename T>
+T TrajectoryReplay::Read(size_t offset) const
+{
+    T value;
+    std::memcpy(&value, &m_Stream[offset], sizeof(T));
+    return value;
+}
+
+//-------------------------------------------------------------------------
+bool TrajectoryReplay::Open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Couldn't open trajectory " << path << "." << std::endl;
+        return false;
+    }
+    m_Stream.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_Stream.data()), m_Stream.size());
+
+    const size_t size = m_Stream.size();
+    bool valid = file && size >= cHeaderSize + cFooterTailSize
+        && std::memcmp(m_Stream.data(), "GOEVTRJ1", 8) == 0
+        && std::memcmp(&m_Stream[size - 8], "GOEVTRJE", 8) == 0;
+    if (valid) {
+        m_SizeX = Read<uint16_t>(8);
+        m_SizeY = Read<uint16_t>(10);
+        m_Generation = Read<uint32_t>(12);
+        m_Population = Read<uint32_t>(16);
+        m_KeyframeStride = Read<uint32_t>(20);
+        m_StepCount = Read<uint32_t>(size - cFooterTailSize);
+        const uint32_t keyframeCount = Read<uint32_t>(size - cFooterTailSize + 4);
+        const uint64_t footerOffset = Read<uint64_t>(size - cFooterTailSize + 8);
+        valid = m_KeyframeStride > 0
+            && keyframeCount == m_StepCount / m_KeyframeStride + 1
+            && footerOffset + keyframeCount * cIndexEntrySize + cFooterTailSize == size;
+        m_Keyframes.clear();
+        m_FooterOffset = footerOffset;
+        // The keyframes follow each other, the step records in between are checked by Advance().
+        uint64_t minOffset = cHeaderSize + m_Population;
+        for (uint32_t keyframe = 0; valid && keyframe < keyframeCount; ++keyframe) {
+            const uint32_t step = Read<uint32_t>(footerOffset + keyframe * cIndexEntrySize);
+            const uint64_t offset = Read<uint64_t>(footerOffset + keyframe * cIndexEntrySize + 4);
+            valid = step == keyframe * m_KeyframeStride
+                && offset >= minOffset
+                && offset + m_Population * cKeyframeEntrySize <= footerOffset;
+            minOffset = offset + m_Population * cKeyframeEntrySize;
+            m_Keyframes.emplace_back(step, offset);
+        }
+    }
+    if (!valid) {
+        std::cerr << "Invalid trajectory " << path << "." << std::endl;
+        m_Stream.clear();
+        m_Keyframes.clear();
+        return false;
+    }
+
+    m_Colors.assign(&m_Stream[cHeaderSize], &m_Stream[cHeaderSize] + m_Population);
+    m_Colors.insert(m_Colors.begin(), 0);
+    m_Locations.assign(m_Population + 1, Coord());
+    m_Alive.assign(m_Population + 1, 0);
+    m_Step = 0;
+    m_Offset = m_Keyframes.front().second;
+    LoadKeyframe();
+    return true;
+}
+
+//-------------------------------------------------------------------------
+void TrajectoryReplay::LoadKeyframe()
+{
+    for (unsigned index = 1; index <= m_Population; ++index, m_Offset += cKeyframeEntrySize) {
+        m_Alive[index] = m_Stream[m_Offset];
+        m_Locations[index] = Coord(Read<int16_t>(m_Offset + 1), Read<int16_t>(m_Offset + 3));
+    }
+}
+
+//-------------------------------------------------------------------------
+bool TrajectoryReplay::Seek(unsigned step)
+{
+    if (m_Keyframes.empty() || step > m_StepCount) {
+        return false;
+    }
+    // Within the current keyframe interval, forward is cheaper than the keyframe.
+    const unsigned keyframe = step / m_KeyframeStride;
+    if (step < m_Step || keyframe != m_Step / m_KeyframeStride) {
+        m_Step = m_Keyframes[keyframe].first;
+        m_Offset = m_Keyframes[keyframe].second;
+        LoadKeyframe();
+    }
+    while (m_Step < step) {
+        if (!Advance()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+bool TrajectoryReplay::Advance()
+{
+    static constexpr int8_t cDeltaX[] = {-1, -1, -1, 0, 0, 0, 1, 1, 1};
+    static constexpr int8_t cDeltaY[] = {-1, 0, 1, -1, 0, 1, -1, 0, 1};
+    if (m_Keyframes.empty() || m_Step >= m_StepCount) {
+        return false;
+    }
+
+    // The record of the step must end before the next keyframe, or the footer.
+    const size_t nextKeyframe = m_Step / m_KeyframeStride + 1;
+    const uint64_t limit = nextKeyframe < m_Keyframes.size() ? m_Keyframes[nextKeyframe].second : m_FooterOffset;
+    size_t aliveCount = 0;
+    for (unsigned index = 1; index <= m_Population; ++index) {
+        aliveCount += m_Alive[index] != 0;
+    }
+    const uint64_t placementsOffset = m_Offset + (aliveCount + 1) / 2;
+    if (placementsOffset + sizeof(uint32_t) > limit
+        || Read<uint32_t>(placementsOffset) > (limit - placementsOffset - sizeof(uint32_t)) / cPlacementSize) {
+        std::cerr << "Corrupt trajectory record of step " << m_Step << "." << std::endl;
+        return false;
+    }
+
+    const uint8_t* pNibbles = &m_Stream[m_Offset];
+    bool highNibble = false;
+    for (unsigned index = 1; index <= m_Population; ++index) {
+        if (!m_Alive[index]) {
+            continue;
+        }
+        const uint8_t code = highNibble ? *pNibbles++ >> 4 : *pNibbles & 0xf;
+        highNibble = !highNibble;
+        if (code < Trajectory::cDied) {
+            m_Locations[index].x += cDeltaX[code];
+            m_Locations[index].y += cDeltaY[code];
+        } else if (code == Trajectory::cDied) {
+            m_Alive[index] = 0;
+        }
+    }
+    m_Offset = pNibbles - m_Stream.data() + highNibble;
+
+    const uint32_t placementCount = Read<uint32_t>(m_Offset);
+    m_Offset += sizeof(placementCount);
+    for (uint32_t placement = 0; placement < placementCount; ++placement, m_Offset += cPlacementSize) {
+        const uint32_t index = Read<uint32_t>(m_Offset);
+        if (index >= 1 && index <= m_Population) {
+            m_Locations[index] = Coord(Read<int16_t>(m_Offset + 4), Read<int16_t>(m_Offset + 6));
+            m_Alive[index] = 1;
+        }
+    }
+
+    // The keyframe of the next step was already applied.
+    if (++m_Step % m_KeyframeStride == 0) {
+        m_Offset = m_Keyframes[nextKeyframe].second + m_Population * cKeyframeEntrySize;
+    }
+    return true;
+}
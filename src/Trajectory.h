@@ -0,0 +1,127 @@
+#pragma once
+
+#include "BasicTypes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Parameters;
+class PeepsPool;
+
+// Trajectory file layout, native byte order:
+//   header:    "GOEVTRJ1", uint16 sizeX, uint16 sizeY, uint32 generation,
+//              uint32 population, uint32 keyframe stride, population * uint8 genetic color
+//   per step:  a keyframe if the step is a multiple of the keyframe stride, then the step
+//   keyframe:  population * (uint8 alive, int16 x, int16 y), the state at the start of the step
+//   step:      one nibble, low nibble first, for each peep alive at the start of the step in
+//              index order, padded to a byte, then uint32 placement count and
+//              placement count * (uint32 peep index, int16 x, int16 y)
+//   footer:    keyframe count * (uint32 step, uint64 file offset), uint32 step count,
+//              uint32 keyframe count, uint64 file offset of the footer, "GOEVTRJE"
+// A nibble 0..8 is the move (dx + 1) * 3 + (dy + 1) with dx, dy in -1..1, cDied means the
+// peep died in the step, cPlaced means it was placed by something else than a move, its new
+// location is in the placement list. A peep in the placement list that was not alive is born.
+
+namespace Trajectory
+{
+    constexpr uint8_t cDied = 9;
+    constexpr uint8_t cPlaced = 10;
+}
+
+/*! \class TrajectoryRecorder
+    \brief Records the peep locations of a generation as per step moves.
+
+    Peeps move by at most one cell per sim step, so a step costs half a byte per living
+    peep. The trajectory of a generation is collected in memory and written to
+    Parameters::imageDir/gen-NNNNNN.trj when the generation ends, see
+    Parameters::saveTrajectories. TrajectoryReplay plays it back.
+*/
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder(const Parameters& params);
+
+    //! Returns the file of the trajectory of \a generation.
+    static std::string FilePath(const Parameters& params, unsigned generation);
+    //! Returns true if the trajectory of the generation is recorded.
+    bool IsRecording(unsigned generation) const;
+    //! Starts the trajectory with the peeps as spawned. Called in single-thread mode.
+    void BeginGeneration(unsigned generation, const PeepsPool& peeps);
+    //! Appends the changes since the last call. Called at the end of each sim step in single-thread mode.
+    void AddStep(const PeepsPool& peeps);
+    //! Writes the trajectory if one was started.
+    void EndGeneration();
+
+private:
+    template <typename T>
+    void Append(const T& value);
+    void AppendKeyframe();
+
+    const Parameters&           m_Params;
+    bool                        m_Recording{false};
+    unsigned                    m_Generation{};
+    unsigned                    m_Step{};               ///< Sim steps recorded so far.
+    std::vector<uint8_t>        m_Stream{};             ///< The file, written by EndGeneration().
+    std::vector<std::pair<uint32_t, uint64_t>> m_Keyframes{};   ///< Step and stream offset of each keyframe.
+    std::vector<Coord>          m_Locations{};          ///< State at the end of the last step, indexed like the peeps.
+    std::vector<uint8_t>        m_Alive{};
+    std::vector<uint8_t>        m_Placements{};         ///< Placement list of the current step.
+};
+
+/*! \class TrajectoryReplay
+    \brief Plays back a file written by TrajectoryRecorder.
+
+    The file is read into memory once. Seek() jumps to the closest keyframe at or before the
+    step and applies the moves from there, at most keyframe stride - 1 steps; no neural net
+    is evaluated. The state is indexed like the peeps, index 0 is unused. The UI plays
+    trajectories through QMLInterface::OpenTrajectory().
+*/
+class TrajectoryReplay
+{
+public:
+    //! Reads and checks the file, then seeks to step 0. Returns false if it is no trajectory.
+    bool Open(const std::string& path);
+
+    unsigned Generation() const { return m_Generation; }
+    uint16_t SizeX() const { return m_SizeX; }
+    uint16_t SizeY() const { return m_SizeY; }
+    unsigned Population() const { return m_Population; }
+    //! Count of the recorded sim steps, the states 0..StepCount() can be reached.
+    unsigned StepCount() const { return m_StepCount; }
+    //! The current state is the one at the start of this sim step.
+    unsigned Step() const { return m_Step; }
+
+    //! Moves to the state at the start of \a step. Returns false if step > StepCount()
+    //! or a step record on the way is corrupt.
+    bool Seek(unsigned step);
+    //! Applies the moves of the current step. Returns false at the end of the trajectory
+    //! and if the step record overruns the next keyframe, the state is unchanged then.
+    bool Advance();
+
+    const std::vector<Coord>& Locations() const { return m_Locations; }
+    const std::vector<uint8_t>& Alive() const { return m_Alive; }
+    //! The genetic colors of the peeps as spawned.
+    const std::vector<uint8_t>& Colors() const { return m_Colors; }
+
+private:
+    template <typename T>
+    T Read(size_t offset) const;
+    //! Loads the keyframe at m_Offset, which must be at the start of a keyframe.
+    void LoadKeyframe();
+
+    std::vector<uint8_t>        m_Stream{};
+    uint16_t                    m_SizeX{};
+    uint16_t                    m_SizeY{};
+    unsigned                    m_Generation{};
+    unsigned                    m_Population{};
+    unsigned                    m_KeyframeStride{1};
+    unsigned                    m_StepCount{};
+    std::vector<std::pair<uint32_t, uint64_t>> m_Keyframes{};
+    uint64_t                    m_FooterOffset{};
+    unsigned                    m_Step{};
+    size_t                      m_Offset{};             ///< Stream offset of the record of m_Step.
+    std::vector<Coord>          m_Locations{};
+    std::vector<uint8_t>        m_Alive{};
+    std::vector<uint8_t>        m_Colors{};
+};
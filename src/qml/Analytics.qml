@@ -181,6 +181,7 @@ Item {
                           case AnalyticsTypes.CompletedTasks:
                           case AnalyticsTypes.SurvivorToNextGen:
                           case AnalyticsTypes.AvgAge:
+                          case AnalyticsTypes.GenerationTimes:
                               requestTimer.interval = 2 * 1000 // 2 Hz
                               break;
                           default:
@@ -2,6 +2,8 @@ import QtQuick 2.0
 import QtQuick.Controls 2.0
 import QtQuick.Layouts 1.2
 
+import backendGuiInterface 1.0
+
 
 //! 2D Canvas to display the world of Peeps.
 Item {
@@ -11,7 +13,8 @@ Item {
     visible: true
     property var challengeShapes: []
     property var barrierShapes: []
-    property var shapes: []
+    //! Provides the peeps to draw.
+    property alias peepsSource: peepsView.source
     //! Holds the simulator to UI scaling. Responsible to enlarge the simulation values.
     property var scaling: 1
     property var peepsOffset: 1
@@ -19,6 +22,12 @@ Item {
     property var gradientStart: Qt.point(0, 0) 
     property var gradientEnd: Qt.point(0, 0) 
     property var gradientColor: "white"
+    //! Number of pheromone layers shown on top of the canvas.
+    property int signalLayerCount: 0
+    //! Changes on every UI update, so that the layer images are requested again.
+    property int signalFrame: 0
+    //! Tint of each pheromone layer.
+    property var signalColors: ["#3060c0", "#c03060", "#30a040", "#c09020"]
 
     //! Signals the current mouse press event.
     signal updateMousePos(var mousePos)
@@ -27,31 +36,27 @@ Item {
 
     //! Clears the canvas of all data.
     function clear() {
-        for(var i = 0; i < shapes.length; i++){
-            shapes[i].destroy()
-        }
         for(var i = 0; i < challengeShapes.length; i++){
             challengeShapes[i].destroy()
         }
         for(var i = 0; i < barrierShapes.length; i++){
             barrierShapes[i].destroy()
         }
-        shapes = []
         challengeShapes = []
         barrierShapes = []
     }
 
-    //! Creates all the peeps requested.
-    function createPeeps(peepsPositions, peepsColors) {
-        var radius = peepRadius * scaling / 2
-        peepsOffset = radius
-        for(var i = 0; i < peepsPositions.length; i++){
-            var position = peepsPositions[i]
-            // Left and top side the peeps are cut in half, the radius offset fixing this.
-            position.x = position.x * scaling + radius
-            position.y = height - (position.y * scaling + radius)
-            shapes.push(peep.createObject(mainview, {"position": position, "fillColor": peepsColors[i], "radius": radius}))
-        }
+    //! Fetches and redraws the peeps of the last sim step.
+    function updatePeeps() {
+        // Left and top side the peeps are cut in half, the radius offset fixing this.
+        peepsOffset = peepRadius * scaling / 2
+        peepsView.Refresh()
+    }
+
+    //! Requests the current pheromone layers.
+    function updateSignals(layerCount) {
+        signalLayerCount = layerCount
+        signalFrame++
     }
 
     //! Creates rectangular challenge element.
@@ -146,11 +151,6 @@ Item {
         gradientColor = color
     }
 
-    //! Peep class to instantiate objects from.
-    Peep {
-        id: peep
-    }
-
     //! Peep class to instantiate objects from.
     Circle {
         id: circle
@@ -227,10 +227,6 @@ Item {
             context.fillStyle = gradient
             context.fillRect(0, 0, width, height)
             context.fill();
-            for(var i = 0; i < mainview.shapes.length; i++){
-                shapes[i].draw(context)
-            }
-
             for(var i = 0; i < mainview.challengeShapes.length; i++){
                 challengeShapes[i].draw(context)
             }
@@ -240,4 +236,40 @@ Item {
             }
         }
     }
+
+    //! Pheromone layers, one grayscale texture each, tinted by the shader.
+    //! The images hold one scanline per world column, turning them by -90 degrees
+    //! puts x to the right and y up like the rest of the canvas.
+    Repeater {
+        model: signalLayerCount
+        ShaderEffect {
+            anchors.centerIn: parent
+            width: parent.height
+            height: parent.width
+            rotation: -90
+            property color tint: signalColors[index % signalColors.length]
+            property variant source: Image {
+                source: "image://signals/" + index + "/" + signalFrame
+                cache: false
+                smooth: false
+                visible: false
+            }
+            fragmentShader: "
+                varying highp vec2 qt_TexCoord0;
+                uniform sampler2D source;
+                uniform lowp vec4 tint;
+                uniform lowp float qt_Opacity;
+                void main() {
+                    gl_FragColor = tint * texture2D(source, qt_TexCoord0).r * qt_Opacity;
+                }"
+        }
+    }
+
+    //! All peeps, drawn by the scene graph in one batch.
+    PeepsItem {
+        id: peepsView
+        anchors.fill: parent
+        scaling: mainview.scaling
+        peepRadius: mainview.peepRadius
+    }
 }
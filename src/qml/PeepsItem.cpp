@@ -0,0 +1,139 @@
+#include "PeepsItem.h"
+
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace QML
+{
+
+//-----------------------------------------------------------------------------
+PeepsItem::PeepsItem(QQuickItem* pParent)
+    : QQuickItem(pParent)
+{
+    setFlag(ItemHasContents, true);
+}
+
+//-----------------------------------------------------------------------------
+void PeepsItem::Refresh()
+{
+    if (m_pSource) {
+        m_pSource->GetPeepSprites(m_Peeps);
+    }
+    update();
+}
+
+//-----------------------------------------------------------------------------
+void PeepsItem::AddQuad(const QRectF& rect, uchar r, uchar g, uchar b, uchar a)
+{
+    m_Quads.push_back({float(rect.left()), float(rect.top()), r, g, b, a});
+    m_Quads.push_back({float(rect.right()), float(rect.top()), r, g, b, a});
+    m_Quads.push_back({float(rect.left()), float(rect.bottom()), r, g, b, a});
+    m_Quads.push_back({float(rect.right()), float(rect.bottom()), r, g, b, a});
+}
+
+//-----------------------------------------------------------------------------
+void PeepsItem::FillPeeps(const QRectF& visible)
+{
+    // Same placement as the other canvas items, y points up.
+    const qreal radius = m_PeepRadius * m_Scaling / 2;
+    for (const auto& peep : m_Peeps) {
+        QRectF rect(peep.x * m_Scaling, height() - (peep.y * m_Scaling + 2 * radius), 2 * radius, 2 * radius);
+        if (visible.intersects(rect)) {
+            AddQuad(rect, peep.r, peep.g, peep.b, 255);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void PeepsItem::FillHeatmap(const QRectF& visible, qreal screenScale)
+{
+    // Square bins of whole world cells, counted over the visible cells only.
+    const int binCells = std::max(1, int(std::ceil(cHeatmapBinPixels / (m_Scaling * screenScale))));
+    const qreal binSize = binCells * m_Scaling;
+    const int firstBinX = std::max(0, int(std::floor(visible.left() / binSize)));
+    const int lastBinX = int(std::floor(visible.right() / binSize));
+    const int firstBinY = std::max(0, int(std::floor((height() - visible.bottom()) / binSize)));
+    const int lastBinY = int(std::floor((height() - visible.top()) / binSize));
+    if (lastBinX < firstBinX || lastBinY < firstBinY) {
+        return;
+    }
+    const int binsX = lastBinX - firstBinX + 1;
+    const int binsY = lastBinY - firstBinY + 1;
+    m_Bins.assign(size_t(binsX) * binsY, 0);
+    for (const auto& peep : m_Peeps) {
+        const int binX = peep.x / binCells - firstBinX;
+        const int binY = peep.y / binCells - firstBinY;
+        if (binX >= 0 && binX < binsX && binY >= 0 && binY < binsY) {
+            ++m_Bins[size_t(binX) * binsY + binY];
+        }
+    }
+
+    // A quarter of the cells taken is drawn fully opaque.
+    const qreal fullCount = std::max(1.0, binCells * binCells / 4.0);
+    for (int binX = 0; binX < binsX; ++binX) {
+        for (int binY = 0; binY < binsY; ++binY) {
+            const unsigned count = m_Bins[size_t(binX) * binsY + binY];
+            if (count == 0) {
+                continue;
+            }
+            const uchar alpha = uchar(64 + 191 * std::min(1.0, count / fullCount));
+            QRectF rect((firstBinX + binX) * binSize, height() - (firstBinY + binY + 1) * binSize, binSize, binSize);
+            AddQuad(rect, uchar(alpha * 0.8), 0, 0, alpha);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+QSGNode* PeepsItem::updatePaintNode(QSGNode* pOldNode, UpdatePaintNodeData*)
+{
+    auto pNode = static_cast<QSGGeometryNode*>(pOldNode);
+    if (!pNode) {
+        pNode = new QSGGeometryNode();
+        auto pGeometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0, QSGGeometry::UnsignedIntType);
+        pGeometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        pNode->setGeometry(pGeometry);
+        pNode->setFlag(QSGNode::OwnsGeometry);
+        pNode->setMaterial(new QSGVertexColorMaterial());
+        pNode->setFlag(QSGNode::OwnsMaterial);
+    }
+
+    // Cull against the part of the item inside the window.
+    QRectF visible = boundingRect();
+    if (window()) {
+        visible &= mapRectFromScene(QRectF(0, 0, window()->width(), window()->height()));
+    }
+    const qreal screenScale = mapRectToScene(QRectF(0, 0, 1, 1)).width();
+    m_Quads.clear();
+    if (m_PeepRadius * m_Scaling * screenScale < cMinPeepPixels) {
+        FillHeatmap(visible, screenScale);
+    } else {
+        FillPeeps(visible);
+    }
+
+    // The buffers only grow, the unused quads are collapsed to a point.
+    QSGGeometry* pGeometry = pNode->geometry();
+    const int quadCount = int(m_Quads.size() / 4);
+    if (quadCount > pGeometry->vertexCount() / 4) {
+        const int capacity = quadCount + quadCount / 4;
+        pGeometry->allocate(capacity * 4, capacity * 6);
+        quint32* pIndices = pGeometry->indexDataAsUInt();
+        for (int quad = 0; quad < capacity; ++quad) {
+            const quint32 first = quad * 4;
+            const quint32 indices[6] = {first, first + 1, first + 2, first + 2, first + 1, first + 3};
+            std::copy_n(indices, 6, &pIndices[quad * 6]);
+        }
+    }
+    QSGGeometry::ColoredPoint2D* pVertices = pGeometry->vertexDataAsColoredPoint2D();
+    std::copy(m_Quads.begin(), m_Quads.end(), pVertices);
+    std::memset(static_cast<void*>(pVertices + m_Quads.size()), 0, (pGeometry->vertexCount() - m_Quads.size()) * sizeof(QSGGeometry::ColoredPoint2D));
+    pGeometry->markVertexDataAsDirty();
+    pNode->markDirty(QSGNode::DirtyGeometry);
+    return pNode;
+}
+
+} // namespace QML
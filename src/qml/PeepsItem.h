@@ -0,0 +1,56 @@
+#pragma once
+
+#include "QMLInterface.h"
+
+#include <QQuickItem>
+#include <QSGGeometry>
+
+#include <vector>
+
+namespace QML
+{
+
+/*! \class PeepsItem
+    \brief Draws all peeps with a single scene graph geometry node.
+
+    Every peep is one quad of the vertex buffer. Only the vertices are rewritten each frame,
+    the index buffer changes only when the buffer has to grow. Peeps outside of the window
+    are culled. When a peep would be smaller than cMinPeepPixels on screen, the item draws
+    the peep density in bins of about cHeatmapBinPixels instead.
+*/
+class PeepsItem
+    : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QML::QMLInterface* source MEMBER m_pSource)
+    Q_PROPERTY(qreal scaling MEMBER m_Scaling)
+    Q_PROPERTY(qreal peepRadius MEMBER m_PeepRadius)
+public:
+    PeepsItem(QQuickItem* pParent = nullptr);
+
+    //! Fetches the peeps of the last sim step from the source and schedules a repaint.
+    Q_INVOKABLE void Refresh();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* pOldNode, UpdatePaintNodeData* pData) override;
+
+private:
+    static constexpr qreal cMinPeepPixels = 2.0;      ///< Smallest peep diameter drawn as a peep.
+    static constexpr qreal cHeatmapBinPixels = 8.0;   ///< Minimum heatmap bin size on screen.
+
+    //! Writes the quads of the peeps within \a visible to m_Quads.
+    void FillPeeps(const QRectF& visible);
+    //! Writes the quads of the density bins within \a visible to m_Quads.
+    void FillHeatmap(const QRectF& visible, qreal screenScale);
+    //! Appends a quad, the color is premultiplied.
+    void AddQuad(const QRectF& rect, uchar r, uchar g, uchar b, uchar a);
+
+    QMLInterface*                               m_pSource{};       ///< Provides the peeps.
+    qreal                                       m_Scaling{1};      ///< Pixels per world cell.
+    qreal                                       m_PeepRadius{1};   ///< Peep diameter in world cells.
+    std::vector<PeepSprite>                     m_Peeps{};         ///< Peeps of the last refresh.
+    std::vector<QSGGeometry::ColoredPoint2D>    m_Quads{};         ///< Vertices of this frame, 4 per quad.
+    std::vector<unsigned>                       m_Bins{};          ///< Peep counts of the heatmap bins.
+};
+
+} // namespace QML
@@ -0,0 +1,51 @@
+// Microbenchmark of RandomUintGenerator, in millions of numbers per second.
+// The optional argument is the count of numbers per measurement.
+
+#include "Random.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+    //! Times \a draw, which returns a checksum so that the loop isn't optimized away.
+    template <typename Draw>
+    void Measure(const char* name, unsigned count, Draw draw)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t checksum = draw(count);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << " " << count / elapsed.count() / 1e6 << " M/s (checksum " << checksum << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000000;
+    RandomUintGenerator random(true);
+    for (unsigned repetition = 0; repetition < 2; ++repetition) {
+        Measure("operator()()        ", count, [&random](unsigned n) {
+            uint64_t checksum = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                checksum += random();
+            }
+            return checksum;
+        });
+        Measure("operator()(0, 1000) ", count, [&random](unsigned n) {
+            uint64_t checksum = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                checksum += random(0, 1000);
+            }
+            return checksum;
+        });
+        Measure("uniform() < 0.3     ", count, [&random](unsigned n) {
+            uint64_t checksum = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                checksum += random.uniform() < 0.3f;
+            }
+            return checksum;
+        });
+    }
+    return 0;
+}
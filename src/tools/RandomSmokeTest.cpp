@@ -0,0 +1,133 @@
+// Statistical smoke test of RandomUintGenerator. It catches a broken refill, seeding or
+// checkpoint state, it is no replacement for a full test battery like PractRand.
+// Returns 0 if every check passes.
+
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned cSamples = 10000000;
+    constexpr unsigned cStreams = 1000000;
+
+    bool Report(const char* name, double value, bool passed)
+    {
+        std::cout << (passed ? "pass " : "FAIL ") << name << " " << value << std::endl;
+        return passed;
+    }
+
+    //! Steps a copy of each lane with the scalar xoshiro128** and compares it with the
+    //! blocks of the vectorized refill.
+    unsigned ReferenceMismatches()
+    {
+        auto rotl = [](uint32_t x, int k) { return (x << k) | (x >> (32 - k)); };
+        RandomUintGenerator random(12345, 7);
+        const RandomUintGenerator::State state = random.state();
+        uint32_t lanes[RandomUintGenerator::cLanes][4];
+        for (unsigned lane = 0; lane < RandomUintGenerator::cLanes; ++lane) {
+            for (unsigned word = 0; word < 4; ++word) {
+                lanes[lane][word] = state.lanes[word][lane];
+            }
+        }
+        unsigned mismatches = 0;
+        for (unsigned block = 0; block < 100; ++block) {
+            for (unsigned round = 0; round < RandomUintGenerator::cBlockSize / RandomUintGenerator::cLanes; ++round) {
+                for (auto& s : lanes) {
+                    const uint32_t expected = rotl(s[1] * 5, 7) * 9;
+                    const uint32_t t = s[1] << 9;
+                    s[2] ^= s[0];
+                    s[3] ^= s[1];
+                    s[1] ^= s[2];
+                    s[0] ^= s[3];
+                    s[2] ^= t;
+                    s[3] = rotl(s[3], 11);
+                    mismatches += random() != expected;
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    //! Restores the state of a generator in the middle of a block into another one.
+    unsigned StateMismatches()
+    {
+        RandomUintGenerator original(true);
+        for (unsigned n = 0; n < 37; ++n) {
+            original();
+        }
+        RandomUintGenerator restored(false);
+        restored.setState(original.state());
+        unsigned mismatches = 0;
+        for (unsigned n = 0; n < 1000; ++n) {
+            mismatches += original() != restored();
+        }
+        return mismatches;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    const unsigned referenceMismatches = ReferenceMismatches();
+    const unsigned stateMismatches = StateMismatches();
+    passed &= Report("reference lane mismatches", referenceMismatches, referenceMismatches == 0);
+    passed &= Report("state restore mismatches", stateMismatches, stateMismatches == 0);
+
+    // Ranges, uniform() and the raw bits of one deterministic generator.
+    RandomUintGenerator random(true);
+    std::vector<double> counts(10);
+    std::vector<double> bits(32);
+    double sum = 0.0;
+    double squares = 0.0;
+    double lagged = 0.0;
+    double previous = 0.5;
+    for (unsigned n = 0; n < cSamples; ++n) {
+        ++counts[random(0, 9)];
+        const float value = random.uniform();
+        if (value < 0.0f || value >= 1.0f) {
+            Report("uniform() out of range", value, false);
+            return 1;
+        }
+        sum += value;
+        squares += value * value;
+        lagged += (value - 0.5) * (previous - 0.5);
+        previous = value;
+        const uint32_t raw = random();
+        for (unsigned bit = 0; bit < 32; ++bit) {
+            bits[bit] += (raw >> bit) & 1;
+        }
+    }
+    double chiSquare = 0.0;
+    for (double count : counts) {
+        chiSquare += (count - cSamples / 10.0) * (count - cSamples / 10.0) / (cSamples / 10.0);
+    }
+    double worstBit = 0.0;
+    for (double count : bits) {
+        worstBit = std::max(worstBit, std::fabs(count / cSamples - 0.5) / std::sqrt(0.25 / cSamples));
+    }
+    const double mean = sum / cSamples;
+    const double variance = squares / cSamples - mean * mean;
+    const double correlation = lagged / cSamples * 12.0;
+    // 27.88 is the 0.999 quantile of the chi-square distribution with 9 degrees of freedom.
+    passed &= Report("chi-square of range(0, 9)", chiSquare, chiSquare < 27.88);
+    passed &= Report("worst bit balance z-score", worstBit, worstBit < 5.0);
+    passed &= Report("uniform() mean", mean, std::fabs(mean - 0.5) < 0.001);
+    passed &= Report("uniform() variance", variance, std::fabs(variance - 1.0 / 12.0) < 0.001);
+    passed &= Report("uniform() lag-1 correlation", correlation, std::fabs(correlation) < 0.003);
+
+    // The per-peep streams of neighbouring indexes must be unrelated.
+    double neighbours = 0.0;
+    for (unsigned stream = 0; stream < cStreams; ++stream) {
+        RandomUintGenerator first(99, stream);
+        RandomUintGenerator second(99, stream + 1);
+        neighbours += (first.uniform() - 0.5) * (second.uniform() - 0.5);
+    }
+    const double neighbourCorrelation = neighbours / cStreams * 12.0;
+    passed &= Report("neighbouring stream correlation", neighbourCorrelation, std::fabs(neighbourCorrelation) < 0.005);
+
+    return passed ? 0 : 1;
+}